@@ -127,6 +127,15 @@ macro(add_leatherman_test)
 endmacro()
 
 
+# Usage: add_leatherman_benchmark(${SOURCE})
+#
+# Adds a benchmark, built as its own executable named
+# lth_<library>_benchmark when LEATHERMAN_ENABLE_BENCHMARKS is set.
+macro(add_leatherman_benchmark source)
+    list(APPEND LEATHERMAN_BENCHMARK_SRCS "${CMAKE_CURRENT_SOURCE_DIR}/${source}")
+    export_var(LEATHERMAN_BENCHMARK_SRCS)
+endmacro()
+
 # Usage: add_leatherman_headers(${DIRECTORIES})
 #
 # Adds the listed directories to the set which will be installed to
@@ -0,0 +1,3 @@
+#pragma once
+
+#define TEST_LIB_DIRECTORY "/tmp/b2/lib"
@@ -430,9 +430,9 @@ namespace leatherman { namespace execution {
             boost::trim_if(buffer, is_any_of("\r"));
 #endif
 
-            // Log the line to the output logger
+            // Log the line to the output logger; it's program output, so don't look it up for translation
             if (LOG_IS_DEBUG_ENABLED()) {
-                log(logger, log_level::debug, 0, buffer);
+                log_raw(logger, log_level::debug, 0, buffer);
             }
 
             // Pass the line to the callback
@@ -487,7 +487,7 @@ namespace leatherman { namespace execution {
         // Log the last line of output for stdout
         if (!stdout_buffer.empty()) {
             if (LOG_IS_DEBUG_ENABLED()) {
-                log(stdout_logger, log_level::debug, 0, stdout_buffer);
+                log_raw(stdout_logger, log_level::debug, 0, stdout_buffer);
             }
             if (stdout_callback) {
                 stdout_callback(stdout_buffer);
@@ -497,7 +497,7 @@ namespace leatherman { namespace execution {
         // Log the last line of output for stderr
         if (!stderr_buffer.empty()) {
             if (LOG_IS_DEBUG_ENABLED()) {
-                log(stderr_logger, log_level::debug, 0, stderr_buffer);
+                log_raw(stderr_logger, log_level::debug, 0, stderr_buffer);
             }
             if (stderr_callback) {
                 stderr_callback(stderr_buffer);
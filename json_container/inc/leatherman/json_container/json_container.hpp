@@ -1,12 +1,20 @@
 #pragma once
 
 #include <vector>
+#include <atomic>
+#include <functional>
 #include <cstdarg>
 #include <iostream>
 #include <tuple>
 #include <typeinfo>
 #include <memory>
+#include <cstddef>
+#include <iterator>
+#include <utility>
+#include <type_traits>
+#include <string>
 #include <leatherman/locale/locale.hpp>
+#include <boost/utility/string_ref.hpp>
 
 // Mark string for translation (alias for leatherman::locale::format)
 using leatherman::locale::_;
@@ -14,6 +22,7 @@ using leatherman::locale::_;
 // Forward declarations for rapidjson
 namespace rapidjson {
     class CrtAllocator;
+    template <typename BaseAllocator> class MemoryPoolAllocator;
     template <typename Encoding, typename Allocator> class GenericValue;
     template <typename CharType> struct UTF8;
     template <typename Encoding, typename Allocator, typename StackAllocator> class GenericDocument;
@@ -22,6 +31,8 @@ namespace rapidjson {
 namespace leatherman { namespace json_container {
     // Constants
     constexpr size_t DEFAULT_LEFT_PADDING { 4 };
+    constexpr size_t DEFAULT_ARENA_CHUNK_SIZE { 64 * 1024 };
+    constexpr size_t DEFAULT_INDEX_THRESHOLD { 32 };
 
     // Errors
 
@@ -59,6 +70,17 @@ namespace leatherman { namespace json_container {
 
     enum DataType { Object, Array, String, Int, Bool, Double, Null };
 
+    /// Options for parsing JSON text, which can be combined with |.
+    enum ParseFlags : unsigned {
+        ParseDefault = 0,
+        /// Parse numbers in full precision (slower).
+        ParseFullPrecision = 1 << 0,
+        /// Allow /* */ and // comments.
+        ParseComments = 1 << 1,
+        /// Allow a comma after the last entry of an object or array.
+        ParseTrailingCommas = 1 << 2
+    };
+
     struct JsonContainerKey : public std::string {
         JsonContainerKey(const std::string& value) : std::string(value) {}
         JsonContainerKey(const char* value) : std::string(value) {}
@@ -66,9 +88,52 @@ namespace leatherman { namespace json_container {
     };
 
     /**
-     * Typedef for RapidJSON allocator.
+     * Settings for a JsonContainer whose nodes are allocated from an arena.
      */
-    using json_allocator = rapidjson::CrtAllocator;
+    struct JsonArena {
+        /// @param chunk_size The size of each chunk the arena allocates once
+        /// the buffer (if any) is used up.
+        /// @param buffer An optional buffer used before any chunk is allocated;
+        /// it's owned by the caller and must outlive the container.
+        /// @param buffer_size The size of the buffer in bytes.
+        explicit JsonArena(size_t chunk_size = DEFAULT_ARENA_CHUNK_SIZE,
+                           void* buffer = nullptr,
+                           size_t buffer_size = 0)
+            : chunk_size(chunk_size), buffer(buffer), buffer_size(buffer_size) {}
+
+        size_t chunk_size;
+        void* buffer;
+        size_t buffer_size;
+    };
+
+    /**
+     * RapidJSON allocator for JsonContainer documents.
+     * By default every node is allocated with malloc and freed on its own.
+     * An arena allocator carves nodes out of the chunks of a RapidJSON
+     * MemoryPoolAllocator instead: freeing a node is a no-op and the
+     * memory is released one chunk at a time when the allocator is
+     * destroyed.
+     */
+    class json_allocator {
+    public:
+        static const bool kNeedFree = true;
+
+        json_allocator();
+        explicit json_allocator(const JsonArena& arena);
+        json_allocator(const json_allocator&) = delete;
+        json_allocator& operator=(const json_allocator&) = delete;
+        ~json_allocator();
+
+        bool usesArena() const;
+
+        void* Malloc(size_t size);
+        void* Realloc(void* original_ptr, size_t original_size, size_t new_size);
+        static void Free(void* ptr);
+
+    private:
+        std::unique_ptr<rapidjson::MemoryPoolAllocator<rapidjson::CrtAllocator>> pool_;
+    };
+
     /**
      * Typedef for RapidJSON value.
      */
@@ -78,6 +143,50 @@ namespace leatherman { namespace json_container {
      */
     using json_document = rapidjson::GenericDocument<rapidjson::UTF8<char>, json_allocator, json_allocator>;
 
+    /**
+     * A path of object keys and array indices, to look up the same entry
+     * repeatedly without building a vector of keys each time.
+     * Each step remembers the position at which its key was last found,
+     * which is tried first on the next lookup, so that documents of the
+     * same shape are looked up without scanning their objects.
+     * A path can be shared between threads.
+     */
+    class JsonPath {
+    public:
+        /// An object key or an array index of a JsonPath.
+        class Step {
+        public:
+            Step(const char* key);
+            Step(const std::string& key);
+
+            template <typename I,
+                      typename = typename std::enable_if<std::is_integral<I>::value>::type>
+            Step(I idx) : idx_(static_cast<size_t>(idx)), hash_(0), is_index_(true), hint_(0) {}
+
+            Step(const Step& other);
+            Step& operator=(const Step& other);
+
+        private:
+            friend class JsonContainer;
+
+            std::string key_;
+            size_t idx_;
+            size_t hash_;
+            bool is_index_;
+            // The position of the member last found with this key
+            mutable std::atomic<size_t> hint_;
+        };
+
+        /// @param steps The keys and indices to follow from the root;
+        /// an empty path refers to the root.
+        explicit JsonPath(std::vector<Step> steps);
+
+    private:
+        friend class JsonContainer;
+
+        std::vector<Step> steps_;
+    };
+
     // Usage:
     //
     // SUPPORTED SCALARS:
@@ -120,6 +229,14 @@ namespace leatherman { namespace json_container {
     // To check if a key is set in object x
     //    x.includes("foo");
     //    x.includes({ "foo", "bar", "baz" });
+    //
+    // To look up the same entry repeatedly, compile its path once
+    //    static const JsonPath path({ "foo", "vec", 1 });
+    //    x.get<int>(path);
+
+    class JsonView;
+    class JsonReader;
+    struct JsonMember;
 
     class JsonContainer {
     public:
@@ -127,13 +244,75 @@ namespace leatherman { namespace json_container {
         explicit JsonContainer(const std::string& json_txt);
         explicit JsonContainer(const json_value& value);
         JsonContainer(const JsonContainer& data);
-        JsonContainer(const JsonContainer&& data);
+
+        /// Create an empty object whose nodes are allocated from an
+        /// arena, so that the whole document is released at once.
+        explicit JsonContainer(const JsonArena& arena);
+
+        /// Parse JSON text into a document allocated from an arena.
+        /// Throw a data_parse_error in case of invalid JSON.
+        JsonContainer(const std::string& json_txt, const JsonArena& arena);
+
+        /// Take the document of the specified container without
+        /// copying it; the moved-from container can only be assigned
+        /// to or destroyed.
+        JsonContainer(JsonContainer&& data) noexcept;
+
         JsonContainer& operator=(JsonContainer other);
 
         ~JsonContainer();
 
+        /// Replace the content of the container by parsing the
+        /// specified text, which doesn't have to be null terminated;
+        /// strings are copied into the document.
+        /// Throw a data_parse_error in case of invalid JSON, leaving
+        /// the container unchanged.
+        void parse(boost::string_ref json_txt, unsigned flags = ParseDefault);
+
+        /// Replace the content of the container by parsing the
+        /// specified text in place: the container keeps the text,
+        /// and its strings point into it rather than being copied.
+        /// Throw a data_parse_error in case of invalid JSON, leaving
+        /// the container unchanged.
+        void parseInsitu(std::string&& json_txt, unsigned flags = ParseDefault);
+
         const json_document& getRaw() const;
 
+        /// Whether the nodes of this container are allocated from an
+        /// arena. Copies of an arena container use malloc as usual.
+        bool usesArena() const;
+
+        /// Callback for each member of an object; return true to keep
+        /// iterating, or false to stop.
+        using member_callback = std::function<bool(boost::string_ref key, const JsonView& value)>;
+
+        /// Callback for each element of an array; return true to keep
+        /// iterating, or false to stop.
+        using element_callback = std::function<bool(const JsonView& element)>;
+
+        /// Call the callback with the key and a view of the value of
+        /// each member of the root object, in order, without copying
+        /// them.
+        /// Return false if the callback stopped, true otherwise.
+        /// Throw a data_type_error in case the root is not an object.
+        bool eachMember(const member_callback& callback) const;
+
+        /// Call the callback with a view of each element of the root
+        /// array, in order, without copying them.
+        /// Return false if the callback stopped, true otherwise.
+        /// Throw a data_type_error in case the root is not an array.
+        bool eachElement(const element_callback& callback) const;
+
+        /// Look up the keys of the objects that have at least the
+        /// specified number of members through a hash index, rather
+        /// than by comparing each key in turn. The index of an object
+        /// is built the first time it's looked up, and kept up to date
+        /// as the container is modified.
+        /// The index belongs to the document: copies of the container,
+        /// and documents assigned to it, aren't indexed. JsonView
+        /// lookups don't use it.
+        void indexObjects(size_t threshold = DEFAULT_INDEX_THRESHOLD);
+
         std::string toString() const;
 
         /// Throw a data_key_error in case the specified key is unknown.
@@ -149,6 +328,22 @@ namespace leatherman { namespace json_container {
 
         std::string toPrettyJson(size_t left_padding = DEFAULT_LEFT_PADDING) const;
 
+        /// Write the JSON text of the container to the specified
+        /// stream, compact or pretty printed as by toPrettyJson,
+        /// without building it in a string first.
+        void writeTo(std::ostream& out, bool pretty = false,
+                     size_t left_padding = DEFAULT_LEFT_PADDING) const;
+
+        /// Write the JSON text of the container to the specified file
+        /// descriptor.
+        /// Throw a data_error in case of write errors.
+        void writeTo(int fd, bool pretty = false,
+                     size_t left_padding = DEFAULT_LEFT_PADDING) const;
+
+        /// Append the JSON text of the container to the specified string.
+        void appendTo(std::string& out, bool pretty = false,
+                      size_t left_padding = DEFAULT_LEFT_PADDING) const;
+
         /// Return true if the root is an empty JSON array or an empty
         /// JSON object, false otherwise.
         bool empty() const;
@@ -167,6 +362,11 @@ namespace leatherman { namespace json_container {
         /// Throw a data_key_error in case of unknown keys.
         size_t size(const std::vector<JsonContainerKey>& keys) const;
 
+        /// Return the number of entries of the specified element;
+        /// return 0 in case it's scalar
+        /// Throw as get(const JsonPath&).
+        size_t size(const JsonPath& path) const;
+
         /// In case the root entry is an object, returns its keys,
         /// otherwise an empty vector.
         std::vector<std::string> keys() const;
@@ -177,6 +377,9 @@ namespace leatherman { namespace json_container {
         /// Whether the specified entry exists.
         bool includes(const std::vector<JsonContainerKey>& keys) const;
 
+        /// Whether the specified entry exists.
+        bool includes(const JsonPath& path) const;
+
         DataType type() const;
 
         /// Throw a data_key_error in case the specified key is unknown.
@@ -199,6 +402,9 @@ namespace leatherman { namespace json_container {
         /// Throw a data_index_error in case the index is out of bound.
         DataType type(const std::vector<JsonContainerKey>& keys, const size_t idx) const;
 
+        /// Throw as get(const JsonPath&).
+        DataType type(const JsonPath& path) const;
+
         /// Return the value of the root entry.
         /// Throw a data_type_error in case the type of the root entry
         /// does not match the specified one.
@@ -260,6 +466,18 @@ namespace leatherman { namespace json_container {
             return getValue<T>(*getValueInJson(keys, true, idx));
         }
 
+        /// Return the value of the entry at the specified path.
+        /// Throw a data_key_error in case a key is unknown.
+        /// Throw a data_index_error in case an index is out of bounds.
+        /// Throw a data_type_error in case the type T doesn't match
+        /// the one of the entry, or in case a key is applied to an
+        /// entry that is not an object or an index to an entry that is
+        /// not an array.
+        template <typename T>
+        T get(const JsonPath& path) const {
+            return getValue<T>(*getValueInJson(path));
+        }
+
         /// Return the value of the specified entry of the root object,
         /// or default_value if the entry doesn't exist.
         /// Throw a data_type_error in case the type T doesn't match
@@ -273,11 +491,11 @@ namespace leatherman { namespace json_container {
                 throw data_type_error { _("not an object") };
             }
 
-            if (!hasKey(*jval, key_data)) {
+            if (!hasKey(*jval, key_data, index_.get())) {
                 return default_value;
             }
 
-            return getValue<T>(*getValueInJson(*jval, key_data));
+            return getValue<T>(*getValueInJson(*jval, key_data, index_.get()));
         }
 
         /// Return the value of the specified nested entry or
@@ -295,15 +513,18 @@ namespace leatherman { namespace json_container {
                 throw data_type_error { _("not an object") };
             }
 
-            if (!hasKey(*jval_obj, key_data)) {
+            if (!hasKey(*jval_obj, key_data, index_.get())) {
                 return default_value;
             }
 
-            return getValue<T>(*getValueInJson(*jval_obj, key_data));
+            return getValue<T>(*getValueInJson(*jval_obj, key_data, index_.get()));
         }
 
         /// Throw a data_key_error in case the root is not a valid JSON
         /// object, so that is not possible to set the entry.
+        /// The value is taken by value and moved into the document, so
+        /// passing an rvalue JsonContainer, or a vector of them, moves
+        /// the subtrees in without copying them.
         template <typename T>
         void set(const JsonContainerKey& key, T value) {
             auto jval = getValueInJson();
@@ -313,11 +534,13 @@ namespace leatherman { namespace json_container {
                 throw data_key_error { _("root is not a valid JSON object") };
             }
 
-            if (!hasKey(*jval, key_data)) {
+            if (!hasKey(*jval, key_data, index_.get())) {
                 createKeyInJson(key_data, *jval);
             }
 
-            setValue<T>(*getValueInJson(*jval, key_data), value);
+            auto& entry = *getValueInJson(*jval, key_data, index_.get());
+            forgetIndexes(entry);
+            setValue<T>(entry, std::move(value));
         }
 
         /// Throw a data_key_error if a known nested key is not associated
@@ -334,44 +557,91 @@ namespace leatherman { namespace json_container {
                     throw data_key_error { _("invalid key supplied; cannot navigate the provided path") };
                 }
 
-                if (!hasKey(*jval, key_data)) {
+                if (!hasKey(*jval, key_data, index_.get())) {
                     createKeyInJson(key_data, *jval);
                 }
 
-                jval = getValueInJson(*jval, key_data);
+                jval = getValueInJson(*jval, key_data, index_.get());
             }
 
-            setValue<T>(*jval, value);
+            forgetIndexes(*jval);
+            setValue<T>(*jval, std::move(value));
+        }
+
+        /// Set the entry at the specified path, adding the missing
+        /// keys as for set(std::vector<JsonContainerKey>, T).
+        /// Throw a data_key_error if a key is applied to an entry that
+        /// is not an object.
+        /// Throw a data_type_error if an index is applied to an entry
+        /// that is not an array, and a data_index_error in case it's
+        /// out of bounds.
+        template <typename T>
+        void set(const JsonPath& path, T value) {
+            auto& entry = *createValueInJson(path);
+            forgetIndexes(entry);
+            setValue<T>(entry, std::move(value));
         }
 
     private:
+        friend class JsonView;
+        friend class JsonReader;
+
+        // Declared before the document, which must be destroyed first
+        std::unique_ptr<json_allocator> arena_;
+        // The text parsed in place, which the strings of the document
+        // point into; kept on the heap so that moves don't relocate it
+        std::unique_ptr<std::string> insitu_text_;
         std::unique_ptr<json_document> document_root_;
 
-        size_t getSize(const json_value& jval) const;
+        // Hash index of the members of large objects, if enabled
+        class MemberIndex;
+        std::unique_ptr<MemberIndex> index_;
+
+        // Whether the nodes of the specified container can be moved
+        // into this one rather than copied
+        bool canMoveFrom(const JsonContainer& other) const;
+
+        // The helpers below only work on the specified value, so that
+        // JsonView can share them
+        static size_t getSize(const json_value& jval);
 
-        DataType getValueType(const json_value& jval) const;
+        static DataType getValueType(const json_value& jval);
 
-        bool hasKey(const json_value& jval, const char* key) const;
+        // The helpers taking a MemberIndex look up large objects
+        // through it, when specified
+        static bool hasKey(const json_value& jval, const char* key,
+                           MemberIndex* index = nullptr);
 
         // NOTE(ale): we cant' use json_value::IsObject directly
         // since we have forward declarations for rapidjson; otherwise
         // we would have an implicit template instantiation error
-        bool isObject(const json_value& jval) const;
+        static bool isObject(const json_value& jval);
 
         // Root object entry accessor
         // Throws a data_type_error in case the specified value is not
         // an object.
         // Throws a data_key_error or if the key is unknown.
-        json_value* getValueInJson(const json_value& jval,
-                                   const char* key) const;
+        static json_value* getValueInJson(const json_value& jval,
+                                          const char* key,
+                                          MemberIndex* index = nullptr);
 
         // Root array entry accessor
         // Throws a data_type_error in case the specified value is not
         // an array.
         // Throws a data_index_error in case the arraye index is out
         // of bounds.
-        json_value* getValueInJson(const json_value& jval,
-                                   const size_t& idx) const;
+        static json_value* getValueInJson(const json_value& jval,
+                                          const size_t& idx);
+
+        // Generic entry accessor starting from the specified value
+        // Throws as the one below.
+        static json_value* getValueInJson(
+            const json_value& root,
+            std::vector<JsonContainerKey>::const_iterator begin,
+            std::vector<JsonContainerKey>::const_iterator end,
+            const bool is_array,
+            const size_t idx,
+            MemberIndex* index = nullptr);
 
         // Generic entry accessor
         // In case any key is specified, throws a data_type_error if
@@ -398,15 +668,388 @@ namespace leatherman { namespace json_container {
             return getValueInJson(keys.cbegin(), keys.cend(), is_array, idx);
         }
 
+        // Return the member of the specified object with the specified
+        // key, or nullptr
+        static json_value* findMember(const json_value& jval, const char* key,
+                                      MemberIndex* index);
+
+        // Compiled path accessors, starting from the specified value
+        // findMember returns the member of the object with the key of
+        // the step, or nullptr.
+        // getValueInJson throws as the generic accessor; findValueInJson
+        // returns nullptr instead.
+        static json_value* findMember(const json_value& jval, const JsonPath::Step& step,
+                                      MemberIndex* index = nullptr);
+        static json_value* getValueInJson(const json_value& root, const JsonPath& path,
+                                          MemberIndex* index = nullptr);
+        static json_value* findValueInJson(const json_value& root, const JsonPath& path,
+                                           MemberIndex* index = nullptr);
+
+        json_value* getValueInJson(const JsonPath& path) const;
+
+        // Return the entry at the specified path, adding missing keys
+        json_value* createValueInJson(const JsonPath& path);
+
         void createKeyInJson(const char* key, json_value& jval);
 
+        // Add an empty object with the specified name to the specified
+        // object
+        void addMember(json_value&& name, json_value& jval);
+
+        // Append the toPrettyString text of the specified value,
+        // walking it once
+        static void appendPrettyString(const json_value& jval, size_t left_padding,
+                                       std::string& out);
+
+        // Drop the indexes of the objects within the specified entry,
+        // which is about to be replaced
+        void forgetIndexes(const json_value& jval);
+
         template<typename T>
-        T getValue(const json_value& value) const;
+        static T getValue(const json_value& value);
 
         template<typename T>
         void setValue(json_value& jval, T new_value);
     };
 
+    /**
+     * A read-only view of an entry of a JsonContainer, or of the whole
+     * document, that doesn't copy it.
+     * A view doesn't own what it refers to: it's valid as long as the
+     * container it was taken from is alive and the entry isn't modified.
+     * It offers the same read API as JsonContainer, and
+     * get<JsonView> returns a view of a nested entry without copying
+     * it, while get<JsonContainer> copies the entry into a new
+     * container.
+     */
+    class JsonView {
+    public:
+        /// Iterates over the elements of an array as views.
+        class const_iterator {
+        public:
+            using iterator_category = std::input_iterator_tag;
+            using value_type = JsonView;
+            using difference_type = std::ptrdiff_t;
+            using pointer = const JsonView*;
+            using reference = JsonView;
+
+            explicit const_iterator(const json_value* element = nullptr)
+                : element_ { element } {}
+
+            JsonView operator*() const { return JsonView { *element_ }; }
+
+            const_iterator& operator++();
+
+            const_iterator operator++(int) {
+                auto previous = *this;
+                ++*this;
+                return previous;
+            }
+
+            bool operator==(const const_iterator& other) const {
+                return element_ == other.element_;
+            }
+
+            bool operator!=(const const_iterator& other) const {
+                return element_ != other.element_;
+            }
+
+        private:
+            const json_value* element_;
+        };
+
+        /// Iterates over the members of an object, giving their keys
+        /// and views of their values.
+        class member_iterator {
+        public:
+            using iterator_category = std::input_iterator_tag;
+            using value_type = JsonMember;
+            using difference_type = std::ptrdiff_t;
+            using pointer = const JsonMember*;
+            using reference = JsonMember;
+
+            explicit member_iterator(const void* member = nullptr)
+                : member_ { member } {}
+
+            JsonMember operator*() const;
+
+            member_iterator& operator++();
+
+            member_iterator operator++(int) {
+                auto previous = *this;
+                ++*this;
+                return previous;
+            }
+
+            bool operator==(const member_iterator& other) const {
+                return member_ == other.member_;
+            }
+
+            bool operator!=(const member_iterator& other) const {
+                return member_ != other.member_;
+            }
+
+        private:
+            // The rapidjson member, whose type is incomplete here
+            const void* member_;
+        };
+
+        /// The members of an object, for range-based for loops.
+        class member_range {
+        public:
+            member_range(member_iterator begin, member_iterator end)
+                : begin_ { begin }, end_ { end } {}
+
+            member_iterator begin() const { return begin_; }
+            member_iterator end() const { return end_; }
+
+        private:
+            member_iterator begin_;
+            member_iterator end_;
+        };
+
+        using member_callback = JsonContainer::member_callback;
+        using element_callback = JsonContainer::element_callback;
+
+        /// View the root of the specified container.
+        explicit JsonView(const JsonContainer& container);
+
+        /// View the specified value.
+        explicit JsonView(const json_value& value);
+
+        const json_value& getRaw() const;
+
+        std::string toString() const;
+
+        /// Throw a data_key_error in case the specified key is unknown.
+        std::string toString(const JsonContainerKey& key) const;
+
+        /// Throw a data_key_error in case the specified key is unknown.
+        std::string toString(const std::vector<JsonContainerKey>& keys) const;
+
+        std::string toPrettyJson(size_t left_padding = DEFAULT_LEFT_PADDING) const;
+
+        /// Write the JSON text of the viewed entry to the specified
+        /// stream, compact or pretty printed as by toPrettyJson,
+        /// without building it in a string first.
+        void writeTo(std::ostream& out, bool pretty = false,
+                     size_t left_padding = DEFAULT_LEFT_PADDING) const;
+
+        /// Write the JSON text of the viewed entry to the specified file
+        /// descriptor.
+        /// Throw a data_error in case of write errors.
+        void writeTo(int fd, bool pretty = false,
+                     size_t left_padding = DEFAULT_LEFT_PADDING) const;
+
+        /// Append the JSON text of the viewed entry to the specified
+        /// string.
+        void appendTo(std::string& out, bool pretty = false,
+                      size_t left_padding = DEFAULT_LEFT_PADDING) const;
+
+        /// Return true if the viewed entry is an empty JSON array or an
+        /// empty JSON object, false otherwise.
+        bool empty() const;
+
+        /// Return the number of entries of the viewed entry in case
+        /// is an object or array; returns 0 in case of a scalar
+        size_t size() const;
+
+        /// Throw a data_key_error in case the specified key is unknown.
+        size_t size(const JsonContainerKey& key) const;
+
+        /// Throw a data_key_error in case of unknown keys.
+        size_t size(const std::vector<JsonContainerKey>& keys) const;
+
+        /// Throw as get(const JsonPath&).
+        size_t size(const JsonPath& path) const;
+
+        /// In case the viewed entry is an object, returns its keys,
+        /// otherwise an empty vector.
+        std::vector<std::string> keys() const;
+
+        /// Whether the specified entry exists.
+        bool includes(const JsonContainerKey& key) const;
+
+        /// Whether the specified entry exists.
+        bool includes(const std::vector<JsonContainerKey>& keys) const;
+
+        /// Whether the specified entry exists.
+        bool includes(const JsonPath& path) const;
+
+        DataType type() const;
+
+        /// Throw a data_key_error in case the specified key is unknown.
+        DataType type(const JsonContainerKey& key) const;
+
+        /// Throw a data_key_error in case of unknown keys.
+        DataType type(const std::vector<JsonContainerKey>& keys) const;
+
+        /// Throw a data_type_error in case the viewed entry is not an array.
+        /// Throw a data_index_error in case the index is out of bounds.
+        DataType type(const size_t idx) const;
+
+        /// Throw a data_key_error in case the specified key is unknown.
+        /// Throw a data_type_error in case the specified entry is not an array.
+        /// Throw a data_index_error in case the index is out of bound.
+        DataType type(const JsonContainerKey& key, const size_t idx) const;
+
+        /// Throw a data_key_error in case of unknown keys.
+        /// Throw a data_type_error in case the specified entry is not an array.
+        /// Throw a data_index_error in case the index is out of bound.
+        DataType type(const std::vector<JsonContainerKey>& keys, const size_t idx) const;
+
+        /// Throw as get(const JsonPath&).
+        DataType type(const JsonPath& path) const;
+
+        /// Return the value of the viewed entry.
+        /// Throw a data_type_error in case of type mismatch.
+        template <typename T>
+        T get() const {
+            return JsonContainer::getValue<T>(*value_);
+        }
+
+        /// Return the value of the specified entry of the viewed object.
+        /// Throw a data_key_error in case the entry does not exist.
+        /// Throw a data_type_error in case of type mismatch.
+        template <typename T>
+        T get(const JsonContainerKey& key) const {
+            return JsonContainer::getValue<T>(
+                *JsonContainer::getValueInJson(*value_, key.data()));
+        }
+
+        /// Return the value of the specified nested entry.
+        /// Throw a data_key_error in case the entry does not exist.
+        /// Throw a data_type_error in case of type mismatch.
+        template <typename T>
+        T get(const std::vector<JsonContainerKey>& keys) const {
+            return JsonContainer::getValue<T>(*find(keys));
+        }
+
+        /// Return the indexed value of the viewed array.
+        /// Throw a data_index_error in case the index is out of bound.
+        /// Throw a data_type_error in case of type mismatch or if the
+        /// viewed entry is not an array.
+        template <typename T>
+        T get(const size_t idx) const {
+            return JsonContainer::getValue<T>(
+                *JsonContainer::getValueInJson(*value_, idx));
+        }
+
+        /// Return the indexed value of the specified array entry.
+        /// Throw a data_key_error in case the array entry is unknown.
+        /// Throw a data_index_error in case the index is out of bound.
+        /// Throw a data_type_error in case of type mismatch or if the
+        /// specified entry is not an array.
+        template <typename T>
+        T get(const JsonContainerKey& key, const size_t idx) const {
+            return JsonContainer::getValue<T>(*find({ key }, true, idx));
+        }
+
+        /// Return the indexed value of the specified nested array
+        /// entry.
+        /// Throw a data_key_error in case the array entry is unknown.
+        /// Throw a data_index_error in case the index is out of bound.
+        /// Throw a data_type_error in case of type mismatch or if the
+        /// specified entry is not an array.
+        template <typename T>
+        T get(const std::vector<JsonContainerKey>& keys, const size_t idx) const {
+            return JsonContainer::getValue<T>(*find(keys, true, idx));
+        }
+
+        /// Return the value of the entry at the specified path.
+        /// Throw as JsonContainer::get(const JsonPath&).
+        template <typename T>
+        T get(const JsonPath& path) const {
+            return JsonContainer::getValue<T>(
+                *JsonContainer::getValueInJson(*value_, path));
+        }
+
+        /// Return the value of the specified entry of the viewed object,
+        /// or default_value if the entry doesn't exist.
+        /// Throw a data_type_error in case the type T doesn't match
+        /// the specified one or if the viewed entry is not an object.
+        template <typename T>
+        T getWithDefault(const JsonContainerKey& key, const T default_value) const {
+            auto key_data = key.data();
+
+            if (!JsonContainer::isObject(*value_)) {
+                throw data_type_error { _("not an object") };
+            }
+
+            if (!JsonContainer::hasKey(*value_, key_data)) {
+                return default_value;
+            }
+
+            return JsonContainer::getValue<T>(
+                *JsonContainer::getValueInJson(*value_, key_data));
+        }
+
+        /// Return the value of the specified nested entry or
+        /// default_value if the entry doesn't exist but its parent is
+        /// an object.
+        /// Throw a data_type_error in case the type T doesn't match
+        /// the specified one or in case the parent of the specified
+        /// entry is not an object.
+        template <typename T>
+        T getWithDefault(const std::vector<JsonContainerKey>& keys, const T& default_value) const {
+            auto key_data = keys.back().data();
+            auto jval_obj = JsonContainer::getValueInJson(
+                *value_, keys.cbegin(), keys.cend()-1, false, 0);
+
+            if (!JsonContainer::isObject(*jval_obj)) {
+                throw data_type_error { _("not an object") };
+            }
+
+            if (!JsonContainer::hasKey(*jval_obj, key_data)) {
+                return default_value;
+            }
+
+            return JsonContainer::getValue<T>(
+                *JsonContainer::getValueInJson(*jval_obj, key_data));
+        }
+
+        /// Iterate over the elements of the viewed array.
+        /// Throw a data_type_error in case the viewed entry is not an array.
+        const_iterator begin() const;
+        const_iterator end() const;
+
+        /// Iterate over the members of the viewed object.
+        /// Throw a data_type_error in case the viewed entry is not an
+        /// object.
+        member_range members() const;
+
+        /// Call the callback for each member of the viewed object, as
+        /// JsonContainer::eachMember.
+        /// Throw a data_type_error in case the viewed entry is not an
+        /// object.
+        bool eachMember(const member_callback& callback) const;
+
+        /// Call the callback for each element of the viewed array, as
+        /// JsonContainer::eachElement.
+        /// Throw a data_type_error in case the viewed entry is not an
+        /// array.
+        bool eachElement(const element_callback& callback) const;
+
+    private:
+        const json_value* value_;
+
+        json_value* find(const std::vector<JsonContainerKey>& keys,
+                         const bool is_array = false,
+                         const size_t idx = 0) const {
+            return JsonContainer::getValueInJson(*value_, keys.cbegin(), keys.cend(),
+                                                 is_array, idx);
+        }
+    };
+
+    /**
+     * A member of an object, as given by JsonView::members(): its key
+     * and a view of its value, both valid as long as the view is.
+     */
+    struct JsonMember {
+        boost::string_ref key;
+        JsonView value;
+    };
+
     template<>
     void JsonContainer::setValue<>(json_value& jval, const std::string& new_value);
 
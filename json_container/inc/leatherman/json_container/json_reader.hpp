@@ -0,0 +1,101 @@
+#pragma once
+
+#include <leatherman/json_container/json_container.hpp>
+#include <boost/utility/string_ref.hpp>
+#include <cstdint>
+#include <functional>
+#include <istream>
+#include <string>
+#include <vector>
+
+namespace leatherman { namespace json_container {
+
+    /// The type of a JsonEvent.
+    enum class JsonEventType { StartObject, EndObject, StartArray, EndArray, Key,
+                               Null, Bool, Int, Double, String };
+
+    /**
+     * An event of a JSON document read by a JsonReader.
+     * Only the value matching the type of the event is set.
+     */
+    struct JsonEvent {
+        JsonEventType type;
+
+        /// The number of objects and arrays enclosing the event; 0 for
+        /// the root value.
+        size_t depth;
+
+        bool bool_value;
+        int64_t int_value;
+        double double_value;
+
+        /// The key or string of Key and String events; it's only valid
+        /// during the callback.
+        boost::string_ref string_value;
+    };
+
+    /**
+     * Reads a JSON document incrementally, without building it in memory.
+     * The events of the document can be passed to a callback, and only the
+     * entries at selected key paths are built, as JsonContainer instances.
+     * Callbacks return true to keep reading, or false to stop.
+     */
+    class JsonReader {
+    public:
+        /// Callback for each event of the document.
+        using event_callback = std::function<bool(const JsonEvent& event)>;
+
+        /// Callback for each selected entry; the entry can be moved out
+        /// of the reader, or read through a JsonView.
+        using entry_callback = std::function<bool(JsonContainer& entry)>;
+
+        /// @param buffer_size The size of the buffer used to read streams
+        /// and file descriptors.
+        explicit JsonReader(size_t buffer_size = 64 * 1024);
+
+        /// Set the callback for the events of the document.
+        void onEvent(event_callback callback);
+
+        /// Select the entry at the specified path of object keys; an
+        /// empty path selects the root.
+        /// Entries within a selected entry aren't selected on their own.
+        void select(std::vector<JsonContainerKey> keys, entry_callback callback);
+
+        /// Select each element of the array at the specified path of
+        /// object keys; an empty path selects the elements of the root.
+        void selectEach(std::vector<JsonContainerKey> keys, entry_callback callback);
+
+        /// Read a document from the specified text.
+        /// Return false if a callback stopped reading, true otherwise.
+        /// Throw a data_parse_error in case of invalid JSON.
+        bool read(boost::string_ref json_txt);
+
+        /// Read a document from the specified stream, until its end.
+        /// Return false if a callback stopped reading, true otherwise.
+        /// Throw a data_parse_error in case of invalid JSON.
+        bool read(std::istream& in);
+
+        /// Read a document from the specified file descriptor, until its
+        /// end.
+        /// Return false if a callback stopped reading, true otherwise.
+        /// Throw a data_parse_error in case of invalid JSON and a
+        /// data_error in case of read errors.
+        bool read(int fd);
+
+    private:
+        struct Selection {
+            std::vector<std::string> keys;
+            bool each;
+            entry_callback callback;
+        };
+
+        struct Handler;
+        template <typename Stream> bool parse(Stream& stream);
+        static json_document& getDocument(JsonContainer& container);
+
+        event_callback event_callback_;
+        std::vector<Selection> selections_;
+        std::vector<char> buffer_;
+    };
+
+}}  // namespace leatherman::json_container
@@ -2,11 +2,27 @@
 #include <leatherman/locale/locale.hpp>
 
 #include <rapidjson/document.h>
-#include <rapidjson/stringbuffer.h>
 #include <rapidjson/prettywriter.h>
 #include <rapidjson/writer.h>
 #include <rapidjson/allocators.h>
 #include <rapidjson/rapidjson.h>
+#include <rapidjson/memorystream.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <mutex>
+#include <new>
+#include <unordered_map>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
 
 // Mark string for translation (alias for leatherman::locale::format)
 using leatherman::locale::_;
@@ -19,11 +35,438 @@ namespace leatherman { namespace json_container {
     // free functions
     //
 
+    // rapidjson output stream collecting the text in a fixed buffer,
+    // which is passed to the sink and reused each time it's full
+    template <typename Sink>
+    class BufferedOutput {
+    public:
+        typedef char Ch;
+
+        explicit BufferedOutput(Sink& sink) : sink_(sink), size_(0) {}
+
+        void Put(Ch c) {
+            if (size_ == sizeof(buffer_)) {
+                Flush();
+            }
+            buffer_[size_++] = c;
+        }
+
+        void Flush() {
+            if (size_) {
+                sink_(buffer_, size_);
+                size_ = 0;
+            }
+        }
+
+    private:
+        Sink& sink_;
+        size_t size_;
+        char buffer_[8 * 1024];
+    };
+
+    template <typename Sink>
+    static void writeValue(const json_value& jval, bool pretty, size_t left_padding, Sink sink) {
+        BufferedOutput<Sink> output { sink };
+
+        if (pretty) {
+            rapidjson::PrettyWriter<BufferedOutput<Sink>> writer { output };
+            writer.SetIndent(' ', static_cast<unsigned>(left_padding));
+            jval.Accept(writer);
+        } else {
+            rapidjson::Writer<BufferedOutput<Sink>> writer { output };
+            jval.Accept(writer);
+        }
+
+        output.Flush();
+    }
+
+    static void appendValue(const json_value& jval, std::string& out,
+                            bool pretty = false, size_t left_padding = 0) {
+        writeValue(jval, pretty, left_padding, [&out](const char* data, size_t size) {
+            out.append(data, size);
+        });
+    }
+
+    static void writeValue(const json_value& jval, std::ostream& out,
+                           bool pretty, size_t left_padding) {
+        writeValue(jval, pretty, left_padding, [&out](const char* data, size_t size) {
+            out.write(data, static_cast<std::streamsize>(size));
+        });
+    }
+
+    static void writeValue(const json_value& jval, int fd,
+                           bool pretty, size_t left_padding) {
+        writeValue(jval, pretty, left_padding, [fd](const char* data, size_t size) {
+            while (size) {
+#ifdef _WIN32
+                auto count = _write(fd, data, static_cast<unsigned int>(size));
+#else
+                auto count = ::write(fd, data, size);
+#endif
+                if (count < 0) {
+                    if (errno == EINTR) {
+                        continue;
+                    }
+                    throw data_error { _("failed to write JSON output: {1}", std::strerror(errno)) };
+                }
+                data += count;
+                size -= static_cast<size_t>(count);
+            }
+        });
+    }
+
     std::string valueToString(const json_value& jval) {
-        rapidjson::StringBuffer buffer;
-        rapidjson::Writer<rapidjson::StringBuffer> writer { buffer };
-        jval.Accept(writer);
-        return buffer.GetString();
+        std::string text;
+        appendValue(jval, text);
+        return text;
+    }
+
+    // Deep copy a value. rapidjson's CopyFrom shares strings that were
+    // parsed in place, which would refer to the text of another container.
+    static void copyValue(const json_value& from, json_value& to, json_allocator& allocator) {
+        switch (from.GetType()) {
+            case rapidjson::kObjectType:
+                to.SetObject();
+                for (json_value::ConstMemberIterator itr = from.MemberBegin();
+                     itr != from.MemberEnd(); ++itr) {
+                    json_value name { itr->name.GetString(), itr->name.GetStringLength(), allocator };
+                    json_value value;
+                    copyValue(itr->value, value, allocator);
+                    to.AddMember(name, value, allocator);
+                }
+                break;
+            case rapidjson::kArrayType:
+                to.SetArray();
+                to.Reserve(from.Size(), allocator);
+                for (json_value::ConstValueIterator itr = from.Begin();
+                     itr != from.End(); ++itr) {
+                    json_value value;
+                    copyValue(*itr, value, allocator);
+                    to.PushBack(value, allocator);
+                }
+                break;
+            case rapidjson::kStringType:
+                to.SetString(from.GetString(), from.GetStringLength(), allocator);
+                break;
+            default:
+                to.CopyFrom(from, allocator);
+        }
+    }
+
+    // Blank out the comments and trailing commas allowed by
+    // ParseComments and ParseTrailingCommas, which rapidjson 1.0 can't
+    // parse, keeping the length of the text.
+    static void blankExtensions(char* text, size_t length, unsigned flags) {
+        auto end = text + length;
+
+        // The end of the comment starting at it, or it if there's none;
+        // unterminated block comments are left for the parser to reject
+        auto commentEnd = [&](char* it) -> char* {
+            if (!(flags & ParseComments) || end - it < 2 || *it != '/') {
+                return it;
+            }
+            if (it[1] == '/') {
+                return std::find(it, end, '\n');
+            }
+            if (it[1] == '*') {
+                for (auto e = it + 2; end - e >= 2; ++e) {
+                    if (e[0] == '*' && e[1] == '/') {
+                        return e + 2;
+                    }
+                }
+            }
+            return it;
+        };
+
+        bool in_string = false;
+
+        for (auto it = text; it < end; ++it) {
+            if (in_string) {
+                if (*it == '\\') {
+                    ++it;
+                } else if (*it == '"') {
+                    in_string = false;
+                }
+                continue;
+            }
+
+            if (*it == '"') {
+                in_string = true;
+                continue;
+            }
+
+            auto comment_end = commentEnd(it);
+            if (comment_end != it) {
+                std::fill(it, comment_end, ' ');
+                it = comment_end - 1;
+                continue;
+            }
+
+            if ((flags & ParseTrailingCommas) && *it == ',') {
+                auto next = it + 1;
+                while (next < end) {
+                    if (*next == ' ' || *next == '\n' || *next == '\r' || *next == '\t') {
+                        ++next;
+                    } else if (commentEnd(next) != next) {
+                        next = commentEnd(next);
+                    } else {
+                        break;
+                    }
+                }
+                if (next < end && (*next == ']' || *next == '}')) {
+                    *it = ' ';
+                }
+            }
+        }
+    }
+
+    // Destroy a document. The nodes of an arena are released with its
+    // chunks, so swap the tree into a value that's never destroyed rather
+    // than letting the document walk every node to free it.
+    static void destroyDocument(std::unique_ptr<json_document>& document, bool arena) {
+        if (arena && document) {
+            alignas(json_value) char storage[sizeof(json_value)];
+            auto tree = new (storage) json_value();
+            tree->Swap(*document);
+        }
+        document.reset();
+    }
+
+    //
+    // json_allocator
+    //
+
+    // Every block starts with a header recording where it was allocated,
+    // since Free is static and so can't ask the allocator. The header
+    // keeps the 8 byte alignment RapidJSON expects.
+    enum class BlockSource : uint64_t { Heap, Arena };
+    const size_t BLOCK_HEADER_SIZE { RAPIDJSON_ALIGN(sizeof(BlockSource)) };
+
+    static void* toBlock(void* header, BlockSource source) {
+        *static_cast<BlockSource*>(header) = source;
+        return static_cast<char*>(header) + BLOCK_HEADER_SIZE;
+    }
+
+    static void* toHeader(void* ptr) {
+        return static_cast<char*>(ptr) - BLOCK_HEADER_SIZE;
+    }
+
+    static BlockSource blockSource(void* ptr) {
+        return *static_cast<BlockSource*>(toHeader(ptr));
+    }
+
+    json_allocator::json_allocator() {}
+
+    json_allocator::json_allocator(const JsonArena& arena) {
+        using pool = rapidjson::MemoryPoolAllocator<rapidjson::CrtAllocator>;
+
+        // MemoryPoolAllocator puts its chunk header (two sizes and a
+        // pointer) at the start of the buffer; ignore a buffer that
+        // can't hold more than that
+        if (arena.buffer && arena.buffer_size > 3 * sizeof(void*) + BLOCK_HEADER_SIZE) {
+            pool_.reset(new pool(arena.buffer, arena.buffer_size, arena.chunk_size));
+        } else {
+            pool_.reset(new pool(arena.chunk_size));
+        }
+    }
+
+    // The pool is an incomplete type in the header
+    json_allocator::~json_allocator() {}
+
+    bool json_allocator::usesArena() const {
+        return pool_ != nullptr;
+    }
+
+    void* json_allocator::Malloc(size_t size) {
+        if (!size) {
+            return nullptr;
+        }
+
+        if (pool_) {
+            return toBlock(pool_->Malloc(size + BLOCK_HEADER_SIZE), BlockSource::Arena);
+        }
+
+        auto header = std::malloc(size + BLOCK_HEADER_SIZE);
+        if (!header) {
+            throw std::bad_alloc();
+        }
+        return toBlock(header, BlockSource::Heap);
+    }
+
+    void* json_allocator::Realloc(void* original_ptr, size_t original_size, size_t new_size) {
+        if (!original_ptr) {
+            return Malloc(new_size);
+        }
+
+        if (!new_size) {
+            Free(original_ptr);
+            return nullptr;
+        }
+
+        auto source = pool_ ? BlockSource::Arena : BlockSource::Heap;
+
+        if (blockSource(original_ptr) != source) {
+            // The block was moved in from a document with another
+            // allocator; take a copy of our own
+            auto ptr = Malloc(new_size);
+            std::memcpy(ptr, original_ptr, std::min(original_size, new_size));
+            Free(original_ptr);
+            return ptr;
+        }
+
+        if (pool_) {
+            return toBlock(pool_->Realloc(toHeader(original_ptr),
+                                          original_size + BLOCK_HEADER_SIZE,
+                                          new_size + BLOCK_HEADER_SIZE),
+                           BlockSource::Arena);
+        }
+
+        auto header = std::realloc(toHeader(original_ptr), new_size + BLOCK_HEADER_SIZE);
+        if (!header) {
+            throw std::bad_alloc();
+        }
+        return toBlock(header, BlockSource::Heap);
+    }
+
+    void json_allocator::Free(void* ptr) {
+        // Arena blocks are released with the arena
+        if (ptr && blockSource(ptr) == BlockSource::Heap) {
+            std::free(toHeader(ptr));
+        }
+    }
+
+    //
+    // MemberIndex
+    //
+
+    // FNV-1a hash of a key
+    static size_t hashKey(const char* key, size_t length) {
+        uint64_t hash = 14695981039346656037ULL;
+        for (size_t i = 0; i < length; ++i) {
+            hash ^= static_cast<unsigned char>(key[i]);
+            hash *= 1099511628211ULL;
+        }
+        return static_cast<size_t>(hash);
+    }
+
+    static bool nameEquals(const json_value& name, const char* key, size_t length) {
+        return name.GetStringLength() == length
+            && std::memcmp(name.GetString(), key, length) == 0;
+    }
+
+    // Hash tables of the positions of the members of large objects, by
+    // the hash of their keys, keyed by the address of each object. A
+    // table is built the first time its object is looked up. Members are
+    // only ever appended to an object, so a table catches up with the
+    // ones added since; the tables of objects that are replaced, or that
+    // are moved when the members of their parent grow, have to be
+    // dropped with forget and forgetMembers.
+    class JsonContainer::MemberIndex {
+    public:
+        explicit MemberIndex(size_t threshold) : threshold_(threshold) {}
+
+        bool covers(const json_value& object) const {
+            return object.MemberCount() >= threshold_;
+        }
+
+        // Return the position of the first member with the specified
+        // key, or the number of members if there's none
+        rapidjson::SizeType find(const json_value& object, const char* key,
+                                 size_t length, size_t hash) {
+            std::lock_guard<std::mutex> lock { mutex_ };
+            auto& table = tables_[&object];
+            auto members = object.MemberBegin();
+            auto count = object.MemberCount();
+
+            if (table.count > count) {
+                table.positions.clear();
+                table.count = 0;
+            }
+
+            for (; table.count < count; ++table.count) {
+                const auto& name = (members + table.count)->name;
+                table.positions.emplace(hashKey(name.GetString(), name.GetStringLength()),
+                                        table.count);
+            }
+
+            auto position = count;
+            auto range = table.positions.equal_range(hash);
+            for (auto it = range.first; it != range.second; ++it) {
+                if (it->second < position && nameEquals((members + it->second)->name, key, length)) {
+                    position = it->second;
+                }
+            }
+            return position;
+        }
+
+        void forget(const json_value& jval) {
+            // Only objects and arrays can hold indexed objects
+            if ((jval.IsObject() && !jval.ObjectEmpty()) || (jval.IsArray() && !jval.Empty())) {
+                clear();
+            }
+        }
+
+        // Drop the tables of the values of the specified members
+        void forgetMembers(const json_value::Member* begin, const json_value::Member* end) {
+            std::less<const void*> before;
+            std::lock_guard<std::mutex> lock { mutex_ };
+            for (auto it = tables_.begin(); it != tables_.end();) {
+                if (!before(it->first, begin) && before(it->first, end)) {
+                    it = tables_.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+        }
+
+        void clear() {
+            std::lock_guard<std::mutex> lock { mutex_ };
+            tables_.clear();
+        }
+
+    private:
+        struct Table {
+            Table() : count(0) {}
+
+            // The number of members in the table
+            rapidjson::SizeType count;
+            std::unordered_multimap<size_t, rapidjson::SizeType> positions;
+        };
+
+        size_t threshold_;
+        std::mutex mutex_;
+        std::unordered_map<const json_value*, Table> tables_;
+    };
+
+    //
+    // JsonPath
+    //
+
+    JsonPath::Step::Step(const char* key)
+            : key_(key), idx_(0), hash_(hashKey(key_.data(), key_.size())),
+              is_index_(false), hint_(0) {
+    }
+
+    JsonPath::Step::Step(const std::string& key)
+            : key_(key), idx_(0), hash_(hashKey(key_.data(), key_.size())),
+              is_index_(false), hint_(0) {
+    }
+
+    JsonPath::Step::Step(const Step& other)
+            : key_(other.key_), idx_(other.idx_), hash_(other.hash_), is_index_(other.is_index_),
+              hint_(other.hint_.load(std::memory_order_relaxed)) {
+    }
+
+    JsonPath::Step& JsonPath::Step::operator=(const Step& other) {
+        key_ = other.key_;
+        idx_ = other.idx_;
+        hash_ = other.hash_;
+        is_index_ = other.is_index_;
+        hint_.store(other.hint_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        return *this;
+    }
+
+    JsonPath::JsonPath(std::vector<Step> steps) : steps_(std::move(steps)) {
     }
 
     //
@@ -45,25 +488,114 @@ namespace leatherman { namespace json_container {
     JsonContainer::JsonContainer(const json_value& value) : JsonContainer() {
         // Because rapidjson disallows the use of copy constructors we pass
         // the json by const reference and recreate it by explicitly copying
-        document_root_->CopyFrom(value, document_root_->GetAllocator());
+        copyValue(value, *document_root_, document_root_->GetAllocator());
     }
 
     JsonContainer::JsonContainer(const JsonContainer& data) : JsonContainer(){
-        document_root_->CopyFrom(*data.document_root_, document_root_->GetAllocator());
+        copyValue(*data.document_root_, *document_root_, document_root_->GetAllocator());
+    }
+
+    JsonContainer::JsonContainer(JsonContainer&& data) noexcept
+            : arena_ { std::move(data.arena_) },
+              insitu_text_ { std::move(data.insitu_text_) },
+              document_root_ { std::move(data.document_root_) },
+              index_ { std::move(data.index_) } {
     }
 
-    JsonContainer::JsonContainer(const JsonContainer&& data) : JsonContainer() {
-        document_root_->CopyFrom(*data.document_root_, document_root_->GetAllocator());
+    JsonContainer::JsonContainer(const JsonArena& arena)
+            : arena_ { new json_allocator(arena) },
+              document_root_ { new json_document(arena_.get()) } {
+        document_root_->SetObject();
+    }
+
+    JsonContainer::JsonContainer(const std::string& json_text, const JsonArena& arena)
+            : JsonContainer(arena) {
+        document_root_->Parse(json_text.data());
+
+        if (document_root_->HasParseError()) {
+            throw data_parse_error { _("invalid json") };
+        }
     }
 
     JsonContainer& JsonContainer::operator=(JsonContainer other) {
+        std::swap(arena_, other.arena_);
+        std::swap(insitu_text_, other.insitu_text_);
         std::swap(document_root_, other.document_root_);
+        std::swap(index_, other.index_);
         return *this;
     }
 
     // unique_ptr requires a complete type at time of destruction. this forces us to
     // either have an empty destructor or use a shared_ptr instead.
-    JsonContainer::~JsonContainer() {}
+    JsonContainer::~JsonContainer() {
+        destroyDocument(document_root_, arena_ != nullptr);
+    }
+
+    // parsing
+
+    void JsonContainer::parse(boost::string_ref json_text, unsigned flags) {
+        if (flags & (ParseComments | ParseTrailingCommas)) {
+            // The text has to be modified, so parse a copy of it in
+            // place rather than copying it again into the document
+            parseInsitu(std::string(json_text.data(), json_text.size()), flags);
+            return;
+        }
+
+        // rapidjson clears the document before parsing, so parse into
+        // a new one to leave the container unchanged on error
+        std::unique_ptr<json_document> document { new json_document(arena_.get()) };
+        rapidjson::MemoryStream stream { json_text.data(), json_text.size() };
+
+        if (flags & ParseFullPrecision) {
+            document->ParseStream<rapidjson::kParseFullPrecisionFlag,
+                                  rapidjson::UTF8<>>(stream);
+        } else {
+            document->ParseStream<rapidjson::kParseDefaultFlags,
+                                  rapidjson::UTF8<>>(stream);
+        }
+
+        if (document->HasParseError()) {
+            throw data_parse_error { _("invalid json") };
+        }
+
+        std::swap(document_root_, document);
+        destroyDocument(document, arena_ != nullptr);
+        insitu_text_.reset();
+
+        if (index_) {
+            index_->clear();
+        }
+    }
+
+    void JsonContainer::parseInsitu(std::string&& json_text, unsigned flags) {
+        std::unique_ptr<std::string> text { new std::string(std::move(json_text)) };
+
+        if (flags & (ParseComments | ParseTrailingCommas)) {
+            blankExtensions(&(*text)[0], text->size(), flags);
+        }
+
+        std::unique_ptr<json_document> document { new json_document(arena_.get()) };
+
+        if (flags & ParseFullPrecision) {
+            document->ParseInsitu<rapidjson::kParseFullPrecisionFlag>(&(*text)[0]);
+        } else {
+            document->ParseInsitu<rapidjson::kParseDefaultFlags>(&(*text)[0]);
+        }
+
+        if (document->HasParseError()) {
+            throw data_parse_error { _("invalid json") };
+        }
+
+        // The previous document may refer to the previous text, so
+        // destroy it first
+        std::swap(document_root_, document);
+        destroyDocument(document, arena_ != nullptr);
+        insitu_text_ = std::move(text);
+
+        if (index_) {
+            index_->clear();
+        }
+    }
 
     // representation
 
@@ -71,6 +603,24 @@ namespace leatherman { namespace json_container {
         return *document_root_;
     }
 
+    bool JsonContainer::usesArena() const {
+        return arena_ != nullptr;
+    }
+
+    // iteration
+
+    bool JsonContainer::eachMember(const member_callback& callback) const {
+        return JsonView { *this }.eachMember(callback);
+    }
+
+    bool JsonContainer::eachElement(const element_callback& callback) const {
+        return JsonView { *this }.eachElement(callback);
+    }
+
+    void JsonContainer::indexObjects(size_t threshold) {
+        index_.reset(new MemberIndex(threshold));
+    }
+
     std::string JsonContainer::toString() const {
         return valueToString(*document_root_);
     }
@@ -86,59 +636,8 @@ namespace leatherman { namespace json_container {
     }
 
     std::string JsonContainer::toPrettyString(size_t left_padding) const {
-        if (empty()) {
-            switch (type()) {
-                case DataType::Object:
-                    return "{}";
-                case DataType::Array:
-                    return "[]";
-                default:
-                    return "\"\"";
-            }
-        }
-
         std::string formatted_data {};
-
-        if (type() == DataType::Object) {
-            for (const auto& key : keys()) {
-                formatted_data += std::string(left_padding, ' ');
-                formatted_data += key + " : ";
-                switch (type(key)) {
-                    case DataType::Object:
-                        // Inner object: add new line, increment padding
-                        formatted_data += "\n";
-                        formatted_data += get<JsonContainer>(key).toPrettyString(
-                                            left_padding + LEFT_PADDING_INCREMENT);
-                        break;
-                    case DataType::Array:
-                        // Array: add raw string, regardless of its items
-                        formatted_data += toString(key);
-                        break;
-                    case DataType::String:
-                        formatted_data += get<std::string>(key);
-                        break;
-                    case DataType::Int:
-                        formatted_data += std::to_string(get<int64_t>(key));
-                        break;
-                    case DataType::Bool:
-                        if (get<bool>(key)) {
-                            formatted_data += "true";
-                        } else {
-                            formatted_data += "false";
-                        }
-                        break;
-                    case DataType::Double:
-                        formatted_data += std::to_string(get<double>(key));
-                        break;
-                    default:
-                        formatted_data += "NULL";
-                }
-                formatted_data += "\n";
-            }
-        } else {
-            formatted_data += toString();
-        }
-
+        appendPrettyString(*document_root_, left_padding, formatted_data);
         return formatted_data;
     }
 
@@ -147,12 +646,21 @@ namespace leatherman { namespace json_container {
     }
 
     std::string JsonContainer::toPrettyJson(size_t left_padding) const {
-        rapidjson::StringBuffer buffer;
-        rapidjson::PrettyWriter<rapidjson::StringBuffer> writer { buffer };
-        writer.SetIndent(' ', left_padding);
-        auto& jval = *getValueInJson();
-        jval.Accept(writer);
-        return buffer.GetString();
+        std::string text;
+        appendValue(*document_root_, text, true, left_padding);
+        return text;
+    }
+
+    void JsonContainer::writeTo(std::ostream& out, bool pretty, size_t left_padding) const {
+        writeValue(*document_root_, out, pretty, left_padding);
+    }
+
+    void JsonContainer::writeTo(int fd, bool pretty, size_t left_padding) const {
+        writeValue(*document_root_, fd, pretty, left_padding);
+    }
+
+    void JsonContainer::appendTo(std::string& out, bool pretty, size_t left_padding) const {
+        appendValue(*document_root_, out, pretty, left_padding);
     }
 
     // capacity
@@ -185,6 +693,11 @@ namespace leatherman { namespace json_container {
         return getSize(*jval);
     }
 
+    size_t JsonContainer::size(const JsonPath& path) const {
+        auto jval = getValueInJson(path);
+        return getSize(*jval);
+    }
+
     // keys
 
     std::vector<std::string> JsonContainer::keys() const {
@@ -207,7 +720,7 @@ namespace leatherman { namespace json_container {
     bool JsonContainer::includes(const JsonContainerKey& key) const {
         auto jval = getValueInJson();
 
-        if (hasKey(*jval, key.data())) {
+        if (hasKey(*jval, key.data(), index_.get())) {
             return true;
         } else {
             return false;
@@ -218,15 +731,19 @@ namespace leatherman { namespace json_container {
         auto jval = getValueInJson();
 
         for (const auto& key : keys) {
-            if (!hasKey(*jval, key.data())) {
+            if (!hasKey(*jval, key.data(), index_.get())) {
                 return false;
             }
-            jval = getValueInJson(*jval, key.data());
+            jval = getValueInJson(*jval, key.data(), index_.get());
         }
 
         return true;
     }
 
+    bool JsonContainer::includes(const JsonPath& path) const {
+        return findValueInJson(*document_root_, path, index_.get()) != nullptr;
+    }
+
     // type
 
     DataType JsonContainer::type() const {
@@ -260,11 +777,16 @@ namespace leatherman { namespace json_container {
         return getValueType(*jval);
     }
 
+    DataType JsonContainer::type(const JsonPath& path) const {
+        auto jval = getValueInJson(path);
+        return getValueType(*jval);
+    }
+
     //
     // Private functions
     //
 
-    size_t JsonContainer::getSize(const json_value& jval) const {
+    size_t JsonContainer::getSize(const json_value& jval) {
         switch (getValueType(jval)) {
             case DataType::Array:
                 return jval.Size();
@@ -275,7 +797,7 @@ namespace leatherman { namespace json_container {
         }
     }
 
-    DataType JsonContainer::getValueType(const json_value& jval) const {
+    DataType JsonContainer::getValueType(const json_value& jval) {
         switch (jval.GetType()) {
             case rapidjson::Type::kNullType:
                 return DataType::Null;
@@ -303,29 +825,41 @@ namespace leatherman { namespace json_container {
 
     // Internal key / index manipulation methods
 
-    bool JsonContainer::hasKey(const json_value& jval, const char* key) const {
-        return (jval.IsObject() && jval.HasMember(key));
+    bool JsonContainer::hasKey(const json_value& jval, const char* key,
+                               MemberIndex* index) {
+        return (jval.IsObject() && findMember(jval, key, index));
     }
 
-    bool JsonContainer::isObject(const json_value& jval) const {
+    bool JsonContainer::isObject(const json_value& jval) {
         return jval.IsObject();
     }
 
+    bool JsonContainer::canMoveFrom(const JsonContainer& other) const {
+        // Nodes of an arena go away with it, and a document in an arena
+        // doesn't free the nodes it holds, so only heap nodes can move
+        // between heap documents; strings parsed in place belong to the
+        // text of the other container
+        return !arena_ && !other.arena_ && !other.insitu_text_;
+    }
+
     json_value* JsonContainer::getValueInJson(const json_value& jval,
-                                                    const char* key) const {
+                                              const char* key,
+                                              MemberIndex* index) {
         if (!jval.IsObject()) {
             throw data_type_error { _("not an object") };
         }
 
-        if (!jval.HasMember(key)) {
+        auto member = findMember(jval, key, index);
+
+        if (!member) {
             throw data_key_error { _("unknown object entry with key: {1}", key) };
         }
 
-        return const_cast<json_value*>(&jval[key]);
+        return member;
     }
 
     json_value* JsonContainer::getValueInJson(const json_value& jval,
-                                                    const size_t& idx) const {
+                                              const size_t& idx) {
         if (getValueType(jval) != DataType::Array) {
             throw data_type_error { _("not an array") };
         }
@@ -341,10 +875,19 @@ namespace leatherman { namespace json_container {
                                               std::vector<JsonContainerKey>::const_iterator end,
                                                     const bool is_array,
                                                     const size_t idx) const {
-        auto jval = dynamic_cast<json_value*>(document_root_.get());
+        return getValueInJson(*document_root_, begin, end, is_array, idx, index_.get());
+    }
+
+    json_value* JsonContainer::getValueInJson(const json_value& root,
+                                              std::vector<JsonContainerKey>::const_iterator begin,
+                                              std::vector<JsonContainerKey>::const_iterator end,
+                                              const bool is_array,
+                                              const size_t idx,
+                                              MemberIndex* index) {
+        auto jval = const_cast<json_value*>(&root);
 
         for (auto it = begin; it != end; ++it) {
-            jval = getValueInJson(*jval, it->data());
+            jval = getValueInJson(*jval, it->data(), index);
         }
 
         if (is_array) {
@@ -354,17 +897,161 @@ namespace leatherman { namespace json_container {
         return jval;
     }
 
+    // Return the position of the first member with the specified key, or
+    // the number of members if there's none
+    static rapidjson::SizeType scanMembers(const json_value& jval, const char* key, size_t length) {
+        rapidjson::SizeType position = 0;
+        for (auto itr = jval.MemberBegin(); itr != jval.MemberEnd(); ++itr, ++position) {
+            if (nameEquals(itr->name, key, length)) {
+                break;
+            }
+        }
+        return position;
+    }
+
+    json_value* JsonContainer::findMember(const json_value& jval, const char* key,
+                                          MemberIndex* index) {
+        auto length = std::strlen(key);
+        auto position = (index && index->covers(jval))
+            ? index->find(jval, key, length, hashKey(key, length))
+            : scanMembers(jval, key, length);
+
+        if (position == jval.MemberCount()) {
+            return nullptr;
+        }
+        return const_cast<json_value*>(&(jval.MemberBegin() + position)->value);
+    }
+
+    json_value* JsonContainer::findMember(const json_value& jval,
+                                          const JsonPath::Step& step,
+                                          MemberIndex* index) {
+        const auto& key = step.key_;
+
+        // Documents of the same shape keep their keys at the same
+        // positions, so try the last one first
+        auto hint = step.hint_.load(std::memory_order_relaxed);
+        if (hint < jval.MemberCount()
+            && nameEquals((jval.MemberBegin() + hint)->name, key.data(), key.size())) {
+            return const_cast<json_value*>(&(jval.MemberBegin() + hint)->value);
+        }
+
+        auto position = (index && index->covers(jval))
+            ? index->find(jval, key.data(), key.size(), step.hash_)
+            : scanMembers(jval, key.data(), key.size());
+
+        if (position == jval.MemberCount()) {
+            return nullptr;
+        }
+        step.hint_.store(position, std::memory_order_relaxed);
+        return const_cast<json_value*>(&(jval.MemberBegin() + position)->value);
+    }
+
+    json_value* JsonContainer::getValueInJson(const json_value& root,
+                                              const JsonPath& path,
+                                              MemberIndex* index) {
+        auto jval = const_cast<json_value*>(&root);
+
+        for (const auto& step : path.steps_) {
+            if (step.is_index_) {
+                jval = getValueInJson(*jval, step.idx_);
+                continue;
+            }
+
+            if (!jval->IsObject()) {
+                throw data_type_error { _("not an object") };
+            }
+
+            jval = findMember(*jval, step, index);
+
+            if (!jval) {
+                throw data_key_error { _("unknown object entry with key: {1}", step.key_) };
+            }
+        }
+
+        return jval;
+    }
+
+    json_value* JsonContainer::findValueInJson(const json_value& root,
+                                               const JsonPath& path,
+                                               MemberIndex* index) {
+        auto jval = const_cast<json_value*>(&root);
+
+        for (const auto& step : path.steps_) {
+            if (step.is_index_) {
+                if (!jval->IsArray() || step.idx_ >= jval->Size()) {
+                    return nullptr;
+                }
+                jval = &(*jval)[static_cast<rapidjson::SizeType>(step.idx_)];
+            } else if (!jval->IsObject() || !(jval = findMember(*jval, step, index))) {
+                return nullptr;
+            }
+        }
+
+        return jval;
+    }
+
+    json_value* JsonContainer::getValueInJson(const JsonPath& path) const {
+        return getValueInJson(*document_root_, path, index_.get());
+    }
+
+    json_value* JsonContainer::createValueInJson(const JsonPath& path) {
+        json_value* jval = document_root_.get();
+
+        for (const auto& step : path.steps_) {
+            if (step.is_index_) {
+                jval = getValueInJson(*jval, step.idx_);
+                continue;
+            }
+
+            if (!jval->IsObject()) {
+                throw data_key_error { _("invalid key supplied; cannot navigate the provided path") };
+            }
+
+            auto member = findMember(*jval, step, index_.get());
+
+            if (!member) {
+                addMember(json_value(step.key_.data(),
+                                     static_cast<rapidjson::SizeType>(step.key_.size()),
+                                     document_root_->GetAllocator()),
+                          *jval);
+                member = &(jval->MemberEnd() - 1)->value;
+            }
+
+            jval = member;
+        }
+
+        return jval;
+    }
+
     void JsonContainer::createKeyInJson(const char* key,
                                         json_value& jval) {
-        jval.AddMember(json_value(key, document_root_->GetAllocator()).Move(),
-                       json_value(rapidjson::kObjectType).Move(),
+        addMember(json_value(key, document_root_->GetAllocator()), jval);
+    }
+
+    void JsonContainer::addMember(json_value&& name, json_value& jval) {
+        auto members = jval.MemberBegin();
+        auto count = jval.MemberCount();
+
+        jval.AddMember(name, json_value(rapidjson::kObjectType).Move(),
                        document_root_->GetAllocator());
+
+        // The members were moved if they had to grow, and with them the
+        // objects they hold
+        if (index_ && count && jval.MemberBegin() != members) {
+            index_->forgetMembers(&*members, &*members + count);
+        }
+    }
+
+    void JsonContainer::forgetIndexes(const json_value& jval) {
+        if (index_) {
+            index_->forget(jval);
+        }
     }
 
     // getValue specialisations
 
     template<>
-    int JsonContainer::getValue<>(const json_value& value) const {
+    int JsonContainer::getValue<>(const json_value& value) {
         if (value.IsNull()) {
             return 0;
         }
@@ -377,7 +1064,7 @@ namespace leatherman { namespace json_container {
     }
 
     template<>
-    int64_t JsonContainer::getValue<>(const json_value& value) const {
+    int64_t JsonContainer::getValue<>(const json_value& value) {
         if (value.IsNull()) {
             return 0;
         }
@@ -390,7 +1077,7 @@ namespace leatherman { namespace json_container {
     }
 
     template<>
-    bool JsonContainer::getValue<>(const json_value& value) const {
+    bool JsonContainer::getValue<>(const json_value& value) {
         if (value.IsNull()) {
             return false;
         }
@@ -403,7 +1090,7 @@ namespace leatherman { namespace json_container {
     }
 
     template<>
-    std::string JsonContainer::getValue<>(const json_value& value) const {
+    std::string JsonContainer::getValue<>(const json_value& value) {
         if (value.IsNull()) {
             return "";
         }
@@ -416,7 +1103,7 @@ namespace leatherman { namespace json_container {
     }
 
     template<>
-    double JsonContainer::getValue<>(const json_value& value) const {
+    double JsonContainer::getValue<>(const json_value& value) {
         if (value.IsNull()) {
             return 0.0;
         }
@@ -429,7 +1116,7 @@ namespace leatherman { namespace json_container {
     }
 
     template<>
-    JsonContainer JsonContainer::getValue<>(const json_value& value) const {
+    JsonContainer JsonContainer::getValue<>(const json_value& value) {
         if (value.IsNull()) {
             JsonContainer container {};
             return container;
@@ -443,14 +1130,16 @@ namespace leatherman { namespace json_container {
     }
 
     template<>
-    json_value JsonContainer::getValue<>(const json_value& value) const {
-        JsonContainer* tmp_this = const_cast<JsonContainer*>(this);
-        json_value v { value, tmp_this->document_root_->GetAllocator() };
+    json_value JsonContainer::getValue<>(const json_value& value) {
+        // Copy onto the heap, so the value can outlive an arena
+        json_allocator allocator {};
+        json_value v {};
+        copyValue(value, v, allocator);
         return v;
     }
 
     template<>
-    std::vector<std::string> JsonContainer::getValue<>(const json_value& value) const {
+    std::vector<std::string> JsonContainer::getValue<>(const json_value& value) {
         std::vector<std::string> tmp {};
 
         if (value.IsNull()) {
@@ -475,7 +1164,7 @@ namespace leatherman { namespace json_container {
     }
 
     template<>
-    std::vector<bool> JsonContainer::getValue<>(const json_value& value) const {
+    std::vector<bool> JsonContainer::getValue<>(const json_value& value) {
         std::vector<bool> tmp {};
 
         if (value.IsNull()) {
@@ -500,7 +1189,7 @@ namespace leatherman { namespace json_container {
     }
 
     template<>
-    std::vector<int> JsonContainer::getValue<>(const json_value& value) const {
+    std::vector<int> JsonContainer::getValue<>(const json_value& value) {
         std::vector<int> tmp {};
 
         if (value.IsNull()) {
@@ -525,7 +1214,7 @@ namespace leatherman { namespace json_container {
     }
 
     template<>
-    std::vector<double> JsonContainer::getValue<>(const json_value& value) const {
+    std::vector<double> JsonContainer::getValue<>(const json_value& value) {
         std::vector<double> tmp {};
 
         if (value.IsNull()) {
@@ -550,7 +1239,7 @@ namespace leatherman { namespace json_container {
     }
 
     template<>
-    std::vector<JsonContainer> JsonContainer::getValue<>(const json_value& value) const {
+    std::vector<JsonContainer> JsonContainer::getValue<>(const json_value& value) {
         std::vector<JsonContainer> tmp {};
 
         if (value.IsNull()) {
@@ -568,10 +1257,34 @@ namespace leatherman { namespace json_container {
                 throw data_type_error { _("not an object") };
             }
 
-            JsonContainer* tmp_this = const_cast<JsonContainer*>(this);
-            const json_value tmpvalue(*itr, tmp_this->document_root_->GetAllocator());
-            JsonContainer tmp_data { tmpvalue };
-            tmp.push_back(tmp_data);
+            tmp.emplace_back(*itr);
+        }
+
+        return tmp;
+    }
+
+    template<>
+    JsonView JsonContainer::getValue<>(const json_value& value) {
+        return JsonView { value };
+    }
+
+    template<>
+    std::vector<JsonView> JsonContainer::getValue<>(const json_value& value) {
+        std::vector<JsonView> tmp {};
+
+        if (value.IsNull()) {
+            return tmp;
+        }
+
+        if (!value.IsArray()) {
+            throw data_type_error { _("not an array") };
+        }
+
+        tmp.reserve(value.Size());
+        for (json_value::ConstValueIterator itr = value.Begin();
+             itr != value.End();
+             itr++) {
+            tmp.emplace_back(*itr);
         }
 
         return tmp;
@@ -653,16 +1366,287 @@ namespace leatherman { namespace json_container {
     void JsonContainer::setValue<>(json_value& jval, std::vector<JsonContainer> new_value ) {
         jval.SetArray();
 
-        for (auto value : new_value) {
-            json_document tmp_value;
-            tmp_value.CopyFrom(*value.document_root_, document_root_->GetAllocator());
-            jval.PushBack(tmp_value, document_root_->GetAllocator());
+        jval.Reserve(static_cast<rapidjson::SizeType>(new_value.size()),
+                     document_root_->GetAllocator());
+
+        // new_value is our own copy, so its documents can be moved in
+        // unless they're in an arena
+        for (auto& value : new_value) {
+            if (canMoveFrom(value)) {
+                jval.PushBack(value.document_root_->Move(), document_root_->GetAllocator());
+            } else {
+                json_value tmp_value {};
+                copyValue(*value.document_root_, tmp_value, document_root_->GetAllocator());
+                jval.PushBack(tmp_value, document_root_->GetAllocator());
+            }
         }
     }
 
     template<>
     void JsonContainer::setValue<>(json_value& jval, JsonContainer new_value ) {
-        jval.CopyFrom(new_value.getRaw(), document_root_->GetAllocator());
+        // As above, take the nodes of our copy rather than copying them again
+        if (canMoveFrom(new_value)) {
+            jval = new_value.document_root_->Move();
+        } else {
+            copyValue(*new_value.document_root_, jval, document_root_->GetAllocator());
+        }
+    }
+
+    // pretty printing
+
+    void JsonContainer::appendPrettyString(const json_value& jval, size_t left_padding,
+                                           std::string& out) {
+        if (!jval.IsObject()) {
+            if (jval.IsArray() && jval.Empty()) {
+                out += "[]";
+            } else {
+                appendValue(jval, out);
+            }
+            return;
+        }
+
+        if (jval.ObjectEmpty()) {
+            out += "{}";
+            return;
+        }
+
+        for (auto itr = jval.MemberBegin(); itr != jval.MemberEnd(); ++itr) {
+            const auto& value = itr->value;
+            out.append(left_padding, ' ');
+            out.append(itr->name.GetString(), itr->name.GetStringLength());
+            out += " : ";
+            switch (getValueType(value)) {
+                case DataType::Object:
+                    // Inner object: add new line, increment padding
+                    out += "\n";
+                    appendPrettyString(value, left_padding + LEFT_PADDING_INCREMENT, out);
+                    break;
+                case DataType::Array:
+                    // Array: add raw string, regardless of its items
+                    appendValue(value, out);
+                    break;
+                case DataType::String:
+                    out.append(value.GetString(), value.GetStringLength());
+                    break;
+                case DataType::Int:
+                    out += std::to_string(getValue<int64_t>(value));
+                    break;
+                case DataType::Bool:
+                    out += value.GetBool() ? "true" : "false";
+                    break;
+                case DataType::Double:
+                    out += std::to_string(value.GetDouble());
+                    break;
+                default:
+                    out += "NULL";
+            }
+            out += "\n";
+        }
+    }
+
+    //
+    // JsonView
+    //
+
+    JsonView::const_iterator& JsonView::const_iterator::operator++() {
+        ++element_;
+        return *this;
+    }
+
+    JsonMember JsonView::member_iterator::operator*() const {
+        auto member = static_cast<const json_value::Member*>(member_);
+        return JsonMember { boost::string_ref { member->name.GetString(),
+                                                member->name.GetStringLength() },
+                            JsonView { member->value } };
+    }
+
+    JsonView::member_iterator& JsonView::member_iterator::operator++() {
+        member_ = static_cast<const json_value::Member*>(member_) + 1;
+        return *this;
+    }
+
+    JsonView::JsonView(const JsonContainer& container) : value_ { &container.getRaw() } {
+    }
+
+    JsonView::JsonView(const json_value& value) : value_ { &value } {
+    }
+
+    const json_value& JsonView::getRaw() const {
+        return *value_;
+    }
+
+    std::string JsonView::toString() const {
+        return valueToString(*value_);
+    }
+
+    std::string JsonView::toString(const JsonContainerKey& key) const {
+        return valueToString(*find({ key }));
+    }
+
+    std::string JsonView::toString(const std::vector<JsonContainerKey>& keys) const {
+        return valueToString(*find(keys));
+    }
+
+    std::string JsonView::toPrettyJson(size_t left_padding) const {
+        std::string text;
+        appendValue(*value_, text, true, left_padding);
+        return text;
+    }
+
+    void JsonView::writeTo(std::ostream& out, bool pretty, size_t left_padding) const {
+        writeValue(*value_, out, pretty, left_padding);
+    }
+
+    void JsonView::writeTo(int fd, bool pretty, size_t left_padding) const {
+        writeValue(*value_, fd, pretty, left_padding);
+    }
+
+    void JsonView::appendTo(std::string& out, bool pretty, size_t left_padding) const {
+        appendValue(*value_, out, pretty, left_padding);
+    }
+
+    bool JsonView::empty() const {
+        switch (JsonContainer::getValueType(*value_)) {
+            case DataType::Object:
+                return value_->ObjectEmpty();
+            case DataType::Array:
+                return value_->Empty();
+            default:
+                return false;
+        }
+    }
+
+    size_t JsonView::size() const {
+        return JsonContainer::getSize(*value_);
+    }
+
+    size_t JsonView::size(const JsonContainerKey& key) const {
+        return JsonContainer::getSize(*find({ key }));
+    }
+
+    size_t JsonView::size(const std::vector<JsonContainerKey>& keys) const {
+        return JsonContainer::getSize(*find(keys));
+    }
+
+    size_t JsonView::size(const JsonPath& path) const {
+        return JsonContainer::getSize(*JsonContainer::getValueInJson(*value_, path));
+    }
+
+    std::vector<std::string> JsonView::keys() const {
+        std::vector<std::string> k;
+
+        if (value_->IsObject()) {
+            k.reserve(value_->MemberCount());
+            for (json_value::ConstMemberIterator itr = value_->MemberBegin();
+                 itr != value_->MemberEnd(); ++itr) {
+                k.emplace_back(itr->name.GetString(), itr->name.GetStringLength());
+            }
+        }
+
+        return k;
+    }
+
+    bool JsonView::includes(const JsonContainerKey& key) const {
+        return JsonContainer::hasKey(*value_, key.data());
+    }
+
+    bool JsonView::includes(const std::vector<JsonContainerKey>& keys) const {
+        auto jval = value_;
+
+        for (const auto& key : keys) {
+            if (!JsonContainer::hasKey(*jval, key.data())) {
+                return false;
+            }
+            jval = JsonContainer::getValueInJson(*jval, key.data());
+        }
+
+        return true;
+    }
+
+    bool JsonView::includes(const JsonPath& path) const {
+        return JsonContainer::findValueInJson(*value_, path) != nullptr;
+    }
+
+    DataType JsonView::type() const {
+        return JsonContainer::getValueType(*value_);
+    }
+
+    DataType JsonView::type(const JsonContainerKey& key) const {
+        return JsonContainer::getValueType(*find({ key }));
+    }
+
+    DataType JsonView::type(const std::vector<JsonContainerKey>& keys) const {
+        return JsonContainer::getValueType(*find(keys));
+    }
+
+    DataType JsonView::type(const size_t idx) const {
+        return JsonContainer::getValueType(*JsonContainer::getValueInJson(*value_, idx));
+    }
+
+    DataType JsonView::type(const JsonContainerKey& key, const size_t idx) const {
+        return JsonContainer::getValueType(*find({ key }, true, idx));
+    }
+
+    DataType JsonView::type(const std::vector<JsonContainerKey>& keys,
+                            const size_t idx) const {
+        return JsonContainer::getValueType(*find(keys, true, idx));
+    }
+
+    DataType JsonView::type(const JsonPath& path) const {
+        return JsonContainer::getValueType(*JsonContainer::getValueInJson(*value_, path));
+    }
+
+    JsonView::const_iterator JsonView::begin() const {
+        if (!value_->IsArray()) {
+            throw data_type_error { _("not an array") };
+        }
+        return const_iterator { value_->Begin() };
+    }
+
+    JsonView::const_iterator JsonView::end() const {
+        if (!value_->IsArray()) {
+            throw data_type_error { _("not an array") };
+        }
+        return const_iterator { value_->End() };
+    }
+
+    JsonView::member_range JsonView::members() const {
+        if (!value_->IsObject()) {
+            throw data_type_error { _("not an object") };
+        }
+        // The members of an empty object may be null, so don't
+        // dereference the iterators
+        return member_range { member_iterator { value_->MemberBegin().operator->() },
+                              member_iterator { value_->MemberEnd().operator->() } };
+    }
+
+    bool JsonView::eachMember(const member_callback& callback) const {
+        if (!value_->IsObject()) {
+            throw data_type_error { _("not an object") };
+        }
+
+        for (auto itr = value_->MemberBegin(); itr != value_->MemberEnd(); ++itr) {
+            boost::string_ref key { itr->name.GetString(), itr->name.GetStringLength() };
+            if (!callback(key, JsonView { itr->value })) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    bool JsonView::eachElement(const element_callback& callback) const {
+        if (!value_->IsArray()) {
+            throw data_type_error { _("not an array") };
+        }
+
+        for (auto itr = value_->Begin(); itr != value_->End(); ++itr) {
+            if (!callback(JsonView { *itr })) {
+                return false;
+            }
+        }
+
+        return true;
     }
 
 }}  // namespace leatherman::json_container
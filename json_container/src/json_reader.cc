@@ -0,0 +1,364 @@
+#include <leatherman/json_container/json_reader.hpp>
+#include <leatherman/locale/locale.hpp>
+
+#include <rapidjson/document.h>
+#include <rapidjson/memorystream.h>
+#include <rapidjson/reader.h>
+#include <rapidjson/rapidjson.h>
+
+#include <cerrno>
+#include <cstring>
+#include <limits>
+#include <memory>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+// Mark string for translation (alias for leatherman::locale::format)
+using leatherman::locale::_;
+
+namespace leatherman { namespace json_container {
+
+    // rapidjson input stream reading chunks into the reader's buffer
+    // from a function returning the number of bytes read, or 0 at the end
+    template <typename Fill>
+    class ChunkedStream {
+    public:
+        typedef char Ch;
+
+        ChunkedStream(std::vector<char>& buffer, Fill fill)
+                : buffer_(buffer), fill_(fill), current_(buffer.data()),
+                  end_(buffer.data()), count_(0), eof_(false) {
+            refill();
+        }
+
+        Ch Peek() const { return current_ < end_ ? *current_ : '\0'; }
+
+        Ch Take() {
+            if (current_ == end_) {
+                return '\0';
+            }
+            Ch c = *current_++;
+            if (current_ == end_) {
+                refill();
+            }
+            return c;
+        }
+
+        size_t Tell() const { return count_ + static_cast<size_t>(current_ - buffer_.data()); }
+
+        // Only needed for in-situ parsing
+        Ch* PutBegin() { RAPIDJSON_ASSERT(false); return nullptr; }
+        void Put(Ch) { RAPIDJSON_ASSERT(false); }
+        void Flush() { RAPIDJSON_ASSERT(false); }
+        size_t PutEnd(Ch*) { RAPIDJSON_ASSERT(false); return 0; }
+
+    private:
+        void refill() {
+            if (eof_) {
+                return;
+            }
+            count_ += static_cast<size_t>(end_ - buffer_.data());
+            auto size = fill_(buffer_.data(), buffer_.size());
+            current_ = buffer_.data();
+            end_ = current_ + size;
+            eof_ = (size == 0);
+        }
+
+        std::vector<char>& buffer_;
+        Fill fill_;
+        const Ch* current_;
+        const Ch* end_;
+        size_t count_;
+        bool eof_;
+    };
+
+    template <typename Fill>
+    static ChunkedStream<Fill> makeStream(std::vector<char>& buffer, Fill fill) {
+        return ChunkedStream<Fill>(buffer, fill);
+    }
+
+    // rapidjson handler tracking the path of each value, passing events to
+    // the event callback and building the selected entries
+    struct JsonReader::Handler {
+        explicit Handler(JsonReader& reader) : stopped(false), reader_(reader), selection_(nullptr) {}
+
+        bool Null() {
+            return scalar(event(JsonEventType::Null), json_value {});
+        }
+
+        bool Bool(bool b) {
+            auto e = event(JsonEventType::Bool);
+            e.bool_value = b;
+            return scalar(e, json_value { b });
+        }
+
+        bool Int(int i) {
+            return Int64(i);
+        }
+
+        bool Uint(unsigned u) {
+            return Int64(u);
+        }
+
+        bool Int64(int64_t i) {
+            auto e = event(JsonEventType::Int);
+            e.int_value = i;
+            return scalar(e, json_value { i });
+        }
+
+        bool Uint64(uint64_t u) {
+            if (u <= static_cast<uint64_t>(std::numeric_limits<int64_t>::max())) {
+                return Int64(static_cast<int64_t>(u));
+            }
+            auto e = event(JsonEventType::Double);
+            e.double_value = static_cast<double>(u);
+            return scalar(e, json_value { u });
+        }
+
+        bool Double(double d) {
+            auto e = event(JsonEventType::Double);
+            e.double_value = d;
+            return scalar(e, json_value { d });
+        }
+
+        bool String(const char* str, rapidjson::SizeType length, bool) {
+            auto e = event(JsonEventType::String);
+            e.string_value = boost::string_ref { str, length };
+            if (!emit(e)) {
+                return false;
+            }
+            if (entry_) {
+                add(json_value { str, length, getDocument(*entry_).GetAllocator() });
+                return true;
+            }
+            if (auto selection = match()) {
+                entry_.reset(new JsonContainer());
+                auto& document = getDocument(*entry_);
+                document.SetString(str, length, document.GetAllocator());
+                return deliver(*selection);
+            }
+            return true;
+        }
+
+        bool Key(const char* str, rapidjson::SizeType length, bool) {
+            frames_.back().key.assign(str, length);
+            auto e = event(JsonEventType::Key);
+            e.string_value = boost::string_ref { str, length };
+            return emit(e);
+        }
+
+        bool StartObject() {
+            return start(JsonEventType::StartObject, rapidjson::kObjectType);
+        }
+
+        bool EndObject(rapidjson::SizeType) {
+            return end(JsonEventType::EndObject);
+        }
+
+        bool StartArray() {
+            return start(JsonEventType::StartArray, rapidjson::kArrayType);
+        }
+
+        bool EndArray(rapidjson::SizeType) {
+            return end(JsonEventType::EndArray);
+        }
+
+        // Whether a callback stopped reading
+        bool stopped;
+
+    private:
+        struct Frame {
+            bool array;
+            // The key of the current member of an object
+            std::string key;
+        };
+
+        JsonEvent event(JsonEventType type) const {
+            JsonEvent e {};
+            e.type = type;
+            e.depth = frames_.size();
+            return e;
+        }
+
+        bool emit(const JsonEvent& e) {
+            if (reader_.event_callback_ && !reader_.event_callback_(e)) {
+                stopped = true;
+                return false;
+            }
+            return true;
+        }
+
+        bool scalar(const JsonEvent& e, json_value value) {
+            if (!emit(e)) {
+                return false;
+            }
+            if (entry_) {
+                add(std::move(value));
+                return true;
+            }
+            if (auto selection = match()) {
+                entry_.reset(new JsonContainer());
+                static_cast<json_value&>(getDocument(*entry_)) = value;
+                return deliver(*selection);
+            }
+            return true;
+        }
+
+        bool start(JsonEventType type, rapidjson::Type value_type) {
+            if (!emit(event(type))) {
+                return false;
+            }
+            if (entry_) {
+                auto parent = open_.back();
+                add(json_value { value_type });
+                // The parent only grows once this entry is closed, so
+                // the pointer stays valid until then
+                open_.push_back(parent->IsArray() ? &(*parent)[parent->Size() - 1]
+                                                  : &(parent->MemberEnd() - 1)->value);
+            } else if (auto selection = match()) {
+                entry_.reset(new JsonContainer());
+                auto& document = getDocument(*entry_);
+                static_cast<json_value&>(document) = json_value { value_type };
+                open_.push_back(&document);
+                selection_ = selection;
+            }
+            frames_.push_back(Frame { type == JsonEventType::StartArray, std::string() });
+            return true;
+        }
+
+        bool end(JsonEventType type) {
+            frames_.pop_back();
+            if (!emit(event(type))) {
+                return false;
+            }
+            if (entry_) {
+                open_.pop_back();
+                if (open_.empty()) {
+                    return deliver(*selection_);
+                }
+            }
+            return true;
+        }
+
+        // Add a value to the innermost open container of the entry
+        void add(json_value value) {
+            auto parent = open_.back();
+            auto& allocator = getDocument(*entry_).GetAllocator();
+            if (parent->IsArray()) {
+                parent->PushBack(value, allocator);
+            } else {
+                const auto& key = frames_.back().key;
+                json_value name { key.data(), static_cast<rapidjson::SizeType>(key.size()), allocator };
+                parent->AddMember(name, value, allocator);
+            }
+        }
+
+        // The selection of the value starting at the current path, if any
+        const Selection* match() const {
+            for (const auto& selection : reader_.selections_) {
+                auto size = selection.keys.size();
+                if (frames_.size() != size + (selection.each ? 1 : 0)
+                    || (selection.each && !frames_.back().array)) {
+                    continue;
+                }
+                size_t i = 0;
+                for (; i < size; ++i) {
+                    if (frames_[i].array || frames_[i].key != selection.keys[i]) {
+                        break;
+                    }
+                }
+                if (i == size) {
+                    return &selection;
+                }
+            }
+            return nullptr;
+        }
+
+        bool deliver(const Selection& selection) {
+            std::unique_ptr<JsonContainer> entry { std::move(entry_) };
+            if (!selection.callback(*entry)) {
+                stopped = true;
+                return false;
+            }
+            return true;
+        }
+
+        JsonReader& reader_;
+        std::vector<Frame> frames_;
+        // The selected entry being built, and its open objects and arrays
+        std::unique_ptr<JsonContainer> entry_;
+        std::vector<json_value*> open_;
+        const Selection* selection_;
+    };
+
+    JsonReader::JsonReader(size_t buffer_size) : buffer_(buffer_size ? buffer_size : 1) {
+    }
+
+    void JsonReader::onEvent(event_callback callback) {
+        event_callback_ = std::move(callback);
+    }
+
+    void JsonReader::select(std::vector<JsonContainerKey> keys, entry_callback callback) {
+        selections_.push_back(Selection { { keys.begin(), keys.end() }, false, std::move(callback) });
+    }
+
+    void JsonReader::selectEach(std::vector<JsonContainerKey> keys, entry_callback callback) {
+        selections_.push_back(Selection { { keys.begin(), keys.end() }, true, std::move(callback) });
+    }
+
+    bool JsonReader::read(boost::string_ref json_text) {
+        rapidjson::MemoryStream stream { json_text.data(), json_text.size() };
+        return parse(stream);
+    }
+
+    bool JsonReader::read(std::istream& in) {
+        auto stream = makeStream(buffer_, [&in](char* buffer, size_t size) -> size_t {
+            in.read(buffer, static_cast<std::streamsize>(size));
+            return static_cast<size_t>(in.gcount());
+        });
+        return parse(stream);
+    }
+
+    bool JsonReader::read(int fd) {
+        auto stream = makeStream(buffer_, [fd](char* buffer, size_t size) -> size_t {
+            while (true) {
+#ifdef _WIN32
+                auto count = _read(fd, buffer, static_cast<unsigned int>(size));
+#else
+                auto count = ::read(fd, buffer, size);
+#endif
+                if (count >= 0) {
+                    return static_cast<size_t>(count);
+                }
+                if (errno != EINTR) {
+                    throw data_error { _("failed to read JSON input: {1}", std::strerror(errno)) };
+                }
+            }
+        });
+        return parse(stream);
+    }
+
+    template <typename Stream>
+    bool JsonReader::parse(Stream& stream) {
+        Handler handler { *this };
+        rapidjson::GenericReader<rapidjson::UTF8<>, rapidjson::UTF8<>, rapidjson::CrtAllocator> reader;
+
+        if (!reader.Parse<rapidjson::kParseDefaultFlags>(stream, handler)) {
+            if (handler.stopped) {
+                return false;
+            }
+            throw data_parse_error { _("invalid json") };
+        }
+
+        return true;
+    }
+
+    json_document& JsonReader::getDocument(JsonContainer& container) {
+        return *container.document_root_;
+    }
+
+}}  // namespace leatherman::json_container
@@ -1,6 +1,16 @@
 #include <catch.hpp>
 #include <leatherman/json_container/json_container.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/nowide/fstream.hpp>
+#include <fcntl.h>
 #include <iostream>
+#include <sstream>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
 
 static const std::string JSON = "{\"foo\" : {\"bar\" : 2},"
                                 " \"goo\" : 1,"
@@ -105,6 +115,159 @@ TEST_CASE("JsonContainer::JsonContainer - passing JSON string", "[data]") {
     }
 }
 
+TEST_CASE("JsonContainer::JsonContainer - moving", "[data]") {
+    JsonContainer data { JSON };
+    auto raw = &data.getRaw();
+
+    SECTION("it takes the document without copying it") {
+        JsonContainer moved { std::move(data) };
+        REQUIRE(&moved.getRaw() == raw);
+        REQUIRE(moved.get<int>("goo") == 1);
+    }
+
+    SECTION("it takes the document on assignment") {
+        JsonContainer moved {};
+        moved = std::move(data);
+        REQUIRE(&moved.getRaw() == raw);
+        REQUIRE(moved.get<std::string>({ "nested", "foo" }) == "bar");
+    }
+
+    SECTION("a moved-from container can be assigned to") {
+        JsonContainer moved { std::move(data) };
+        data = JsonContainer { "[1, 2]" };
+        REQUIRE(data.size() == 2);
+    }
+}
+
+TEST_CASE("JsonContainer::JsonContainer - arena", "[data]") {
+    SECTION("it can build a document in an arena") {
+        JsonContainer data { JsonArena { 256 } };
+        REQUIRE(data.usesArena());
+
+        for (int i = 0; i < 100; i++) {
+            data.set<std::string>("key " + std::to_string(i), "a long enough string value");
+        }
+        data.set<std::vector<int>>({ "nested", "ints" }, { 1, 2, 3 });
+        data.set<int>("key 42", 42);
+
+        REQUIRE(data.size() == 101);
+        REQUIRE(data.get<int>("key 42") == 42);
+        REQUIRE(data.get<std::string>("key 99") == "a long enough string value");
+        REQUIRE(data.get<std::vector<int>>({ "nested", "ints" }).size() == 3);
+    }
+
+    SECTION("it can parse into an arena with a caller supplied buffer") {
+        char buffer[512];
+        JsonContainer data { JSON, JsonArena { 1024, buffer, sizeof(buffer) } };
+        REQUIRE(data.usesArena());
+        REQUIRE(data.get<int>({ "foo", "bar" }) == 2);
+        REQUIRE(data.get<std::string>("string_with_null") == std::string("a string\0with\0null", 18));
+        REQUIRE(data.toString() == JsonContainer { JSON }.toString());
+    }
+
+    SECTION("it throws a data_parse_error in case of invalid JSON") {
+        REQUIRE_THROWS_AS(JsonContainer("{\"foo\" : }", JsonArena {}), data_parse_error);
+    }
+
+    SECTION("copies and entries outlive the arena") {
+        JsonContainer heap {};
+        std::unique_ptr<JsonContainer> copy;
+        {
+            JsonContainer data { JSON, JsonArena {} };
+            copy.reset(new JsonContainer(data));
+            heap.set<JsonContainer>("moved", std::move(data));
+        }
+        REQUIRE_FALSE(copy->usesArena());
+        REQUIRE(copy->get<std::string>({ "nested", "foo" }) == "bar");
+        REQUIRE(heap.get<std::string>({ "moved", "nested", "foo" }) == "bar");
+    }
+
+    SECTION("it can take entries from heap containers") {
+        JsonContainer data { JsonArena {} };
+        JsonContainer heap { JSON };
+        data.set<JsonContainer>("moved", std::move(heap));
+        std::vector<JsonContainer> objects { JsonContainer { JSON }, JsonContainer { JSON } };
+        data.set<std::vector<JsonContainer>>("objects", std::move(objects));
+        REQUIRE(data.get<int>({ "moved", "goo" }) == 1);
+        REQUIRE(data.get<std::vector<JsonContainer>>("objects").size() == 2);
+    }
+}
+
+TEST_CASE("JsonContainer::parse", "[data]") {
+    JsonContainer data {};
+
+    SECTION("it parses text that isn't null terminated") {
+        std::string text { "[1, 2, 3]garbage" };
+        data.parse(boost::string_ref { text.data(), 9 });
+        REQUIRE(data.size() == 3);
+        REQUIRE(data.get<int>(2) == 3);
+    }
+
+    SECTION("it copies strings into the document") {
+        std::string text { JSON };
+        data.parse(text);
+        text.assign(text.size(), ' ');
+        REQUIRE(data.get<std::string>({ "nested", "foo" }) == "bar");
+    }
+
+    SECTION("it can parse numbers in full precision") {
+        data.parse("[0.3]", ParseFullPrecision);
+        REQUIRE(data.get<double>(0) == 0.3);
+    }
+
+    SECTION("it can allow comments and trailing commas") {
+        std::string text { "// comment\n"
+                           "{ \"a\" : [1, 2, /* comment */ ], \"b\" : \"/* not, a comment */\", }" };
+        REQUIRE_THROWS_AS(data.parse(text), data_parse_error);
+        REQUIRE_THROWS_AS(data.parse(text, ParseComments), data_parse_error);
+        data.parse(text, ParseComments | ParseTrailingCommas);
+        REQUIRE(data.get<std::vector<int>>("a") == (std::vector<int> { 1, 2 }));
+        REQUIRE(data.get<std::string>("b") == "/* not, a comment */");
+    }
+
+    SECTION("it leaves the container unchanged in case of invalid JSON") {
+        data.set<int>("foo", 1);
+        REQUIRE_THROWS_AS(data.parse("{\"foo\" : }"), data_parse_error);
+        REQUIRE_THROWS_AS(data.parseInsitu("{\"foo\" : }"), data_parse_error);
+        REQUIRE(data.get<int>("foo") == 1);
+    }
+}
+
+TEST_CASE("JsonContainer::parseInsitu", "[data]") {
+    JsonContainer data {};
+    data.parseInsitu(std::string { JSON });
+
+    SECTION("it parses the text") {
+        REQUIRE(data.get<int>({ "foo", "bar" }) == 2);
+        REQUIRE(data.get<std::string>("string_with_null") == std::string("a string\0with\0null", 18));
+        REQUIRE(data.get<std::vector<std::string>>("string_vec")[0] == "one");
+    }
+
+    SECTION("it keeps the text when the container is moved") {
+        JsonContainer moved { std::move(data) };
+        REQUIRE(moved.get<std::string>({ "nested", "foo" }) == "bar");
+    }
+
+    SECTION("copies and entries outlive the container") {
+        JsonContainer heap {};
+        std::unique_ptr<JsonContainer> copy { new JsonContainer(data) };
+        auto nested = data.get<JsonContainer>("nested");
+        heap.set<JsonContainer>("moved", std::move(data));
+        data = JsonContainer {};
+        REQUIRE(copy->get<std::string>("string") == "a string");
+        REQUIRE(nested.get<std::string>("foo") == "bar");
+        REQUIRE(heap.get<std::string>({ "moved", "nested", "foo" }) == "bar");
+    }
+
+    SECTION("it can parse in place into an arena") {
+        JsonContainer arena { JsonArena {} };
+        arena.parseInsitu("{\"a\" : [1, 2,], /* comment */ \"b\" : \"c\"}", ParseComments | ParseTrailingCommas);
+        REQUIRE(arena.usesArena());
+        REQUIRE(arena.get<std::string>("b") == "c");
+        REQUIRE(arena.size("a") == 2);
+    }
+}
+
 TEST_CASE("JsonContainer::get for object entries", "[data]") {
     JsonContainer data { JSON };
 
@@ -511,6 +674,29 @@ TEST_CASE("JsonContainer::toPrettyString", "[data]") {
             REQUIRE_NOTHROW(data_ooa.toPrettyString());
         }
     }
+
+    SECTION("it formats the entries of an object") {
+        JsonContainer data { "{\"foo\" : {\"bar\" : 2, \"baz\" : {}}, \"vec\" : [1, \"2\"],"
+                             " \"string\" : \"a string\", \"bool\" : false,"
+                             " \"null\" : null, \"real\" : 1.5}" };
+        REQUIRE(data.toPrettyString(2) == "  foo : \n"
+                                          "    bar : 2\n"
+                                          "    baz : \n"
+                                          "{}\n"
+                                          "\n"
+                                          "  vec : [1,\"2\"]\n"
+                                          "  string : a string\n"
+                                          "  bool : false\n"
+                                          "  null : NULL\n"
+                                          "  real : 1.500000\n");
+    }
+
+    SECTION("it formats empty and scalar roots") {
+        REQUIRE(JsonContainer { "{}" }.toPrettyString() == "{}");
+        REQUIRE(JsonContainer { "[]" }.toPrettyString() == "[]");
+        REQUIRE(JsonContainer { "[1, 2]" }.toPrettyString() == "[1,2]");
+        REQUIRE(JsonContainer { "\"text\"" }.toPrettyString() == "\"text\"");
+    }
 }
 
 TEST_CASE("JsonContainer::toPrettyJson", "[data]") {
@@ -897,6 +1083,39 @@ TEST_CASE("JsonContainer::set", "[data]") {
         REQUIRE_THROWS_AS(d_c.set<std::string>({ "vec", "foo" }, "bar"),
                           data_key_error);
     }
+
+    SECTION("it can move a JsonContainer into an entry") {
+        JsonContainer tmp { JSON };
+        msg.set<JsonContainer>("moved", std::move(tmp));
+        REQUIRE(msg.get<int>({ "moved", "foo", "bar" }) == 2);
+        REQUIRE(msg.get<std::string>({ "moved", "nested", "foo" }) == "bar");
+
+        JsonContainer nested {};
+        nested.set<bool>("b", true);
+        msg.set({ "moved", "nested", "inner" }, std::move(nested));
+        REQUIRE(msg.get<bool>({ "moved", "nested", "inner", "b" }));
+    }
+
+    SECTION("it can move a vector of JsonContainers into an entry") {
+        std::vector<JsonContainer> tmp {};
+        for (int i = 0; i < 3; i++) {
+            JsonContainer element {};
+            element.set<int>("i", i);
+            tmp.push_back(std::move(element));
+        }
+        msg.set<std::vector<JsonContainer>>("objects", std::move(tmp));
+
+        auto objects = msg.get<std::vector<JsonContainer>>("objects");
+        REQUIRE(objects.size() == 3);
+        REQUIRE(objects[2].get<int>("i") == 2);
+    }
+
+    SECTION("it leaves a copied JsonContainer unchanged") {
+        JsonContainer tmp { JSON };
+        msg.set<JsonContainer>("copied", tmp);
+        REQUIRE(msg.get<int>({ "copied", "goo" }) == 1);
+        REQUIRE(tmp.get<int>("goo") == 1);
+    }
 }
 
 TEST_CASE("JsonContainer::keys", "[data]") {
@@ -1129,3 +1348,364 @@ TEST_CASE("JsonContainer::type for arrays entries", "[data]") {
         }
     }
 }
+
+TEST_CASE("JsonView", "[data]") {
+    JsonContainer data { JSON };
+    data.set<JsonContainer>("objects", JsonContainer { "[{\"i\" : 0}, {\"i\" : 1}, {\"i\" : 2}]" });
+
+    SECTION("it views the root of a container") {
+        JsonView view { data };
+        REQUIRE(static_cast<const void*>(&view.getRaw()) == &data.getRaw());
+        REQUIRE(view.type() == DataType::Object);
+        REQUIRE(view.size() == data.size());
+        REQUIRE(view.keys() == data.keys());
+        REQUIRE(view.toString() == data.toString());
+        REQUIRE_FALSE(view.empty());
+    }
+
+    SECTION("it can get values") {
+        JsonView view { data };
+        REQUIRE(view.get<int>("goo") == 1);
+        REQUIRE(view.get<int>({ "foo", "bar" }) == 2);
+        REQUIRE(view.get<std::string>("string_with_null") == std::string("a string\0with\0null", 18));
+        REQUIRE(view.get<std::vector<int>>("vec") == (std::vector<int> { 1, 2 }));
+        REQUIRE(view.get<int>("vec", 1) == 2);
+        REQUIRE(view.get<std::string>("string_vec", 0) == "one");
+        REQUIRE(view.get<JsonContainer>("nested").get<std::string>("foo") == "bar");
+        REQUIRE(view.getWithDefault<int>("missing", 5) == 5);
+        REQUIRE(view.getWithDefault<std::string>({ "nested", "foo" }, "") == "bar");
+    }
+
+    SECTION("it can view nested entries without copying them") {
+        auto nested = data.get<JsonView>("nested");
+        REQUIRE(nested.includes("foo"));
+        REQUIRE_FALSE(nested.includes({ "foo", "bar" }));
+        REQUIRE(nested.type("foo") == DataType::String);
+        REQUIRE(nested.toString("foo") == "\"bar\"");
+
+        auto bar = JsonView { data }.get<JsonView>({ "foo", "bar" });
+        REQUIRE(bar.get<int>() == 2);
+        REQUIRE(bar.size() == 0);
+    }
+
+    SECTION("it can view array elements") {
+        auto objects = data.get<std::vector<JsonView>>("objects");
+        REQUIRE(objects.size() == 3);
+        REQUIRE(objects[2].get<int>("i") == 2);
+        REQUIRE(JsonView { data }.type("objects", 1) == DataType::Object);
+    }
+
+    SECTION("it can iterate over an array") {
+        int expected = 0;
+        for (auto element : data.get<JsonView>("objects")) {
+            REQUIRE(element.get<int>("i") == expected++);
+        }
+        REQUIRE(expected == 3);
+    }
+
+    SECTION("it throws the same errors as JsonContainer") {
+        JsonView view { data };
+        REQUIRE_THROWS_AS(view.get<int>("unknown"), data_key_error);
+        REQUIRE_THROWS_AS(view.get<int>("string"), data_type_error);
+        REQUIRE_THROWS_AS(view.get<int>("vec", 2), data_index_error);
+        REQUIRE_THROWS_AS(view.begin(), data_type_error);
+    }
+}
+
+TEST_CASE("JsonContainer::writeTo", "[data]") {
+    JsonContainer data { JSON };
+    std::string big_string(20000, 'x');
+    data.set<std::string>("big", big_string);
+
+    SECTION("it writes the same text as toString to a stream") {
+        std::ostringstream out;
+        data.writeTo(out);
+        REQUIRE(out.str() == data.toString());
+    }
+
+    SECTION("it writes the same text as toPrettyJson to a stream") {
+        std::ostringstream out;
+        data.writeTo(out, true, 2);
+        REQUIRE(out.str() == data.toPrettyJson(2));
+    }
+
+    SECTION("it writes a scalar") {
+        std::ostringstream out;
+        JsonContainer { "42" }.writeTo(out);
+        REQUIRE(out.str() == "42");
+    }
+
+    SECTION("it appends to a string") {
+        std::string out { "prefix " };
+        data.appendTo(out);
+        REQUIRE(out == "prefix " + data.toString());
+    }
+
+    SECTION("it writes a view of an entry") {
+        std::string out;
+        data.get<JsonView>("nested").appendTo(out);
+        REQUIRE(out == data.toString("nested"));
+        REQUIRE(data.get<JsonView>("nested").toPrettyJson() == "{\n    \"foo\": \"bar\"\n}");
+    }
+
+    SECTION("it writes to a file descriptor") {
+        auto path = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("lth_json_writer_%%%%-%%%%");
+        int fd = open(path.string().c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0600);
+        REQUIRE(fd >= 0);
+        data.writeTo(fd, true);
+        close(fd);
+
+        std::stringstream text;
+        {
+            boost::nowide::ifstream in(path.string().c_str());
+            text << in.rdbuf();
+        }
+        boost::filesystem::remove(path);
+        REQUIRE(text.str() == data.toPrettyJson());
+    }
+}
+
+TEST_CASE("JsonPath", "[data]") {
+    JsonContainer data { JSON };
+    const JsonPath vec_path({ "vec", 1 });
+    const JsonPath nested_path({ "nested", "foo" });
+
+    SECTION("it gets entries by keys and indices") {
+        REQUIRE(data.get<int>(vec_path) == 2);
+        REQUIRE(data.get<std::string>(nested_path) == "bar");
+        REQUIRE(data.get<std::string>(JsonPath({ "string_with_null" })) == std::string("a string\0with\0null", 18));
+        REQUIRE(data.get<int>(JsonPath({ "foo", "bar" })) == 2);
+    }
+
+    SECTION("an empty path refers to the root") {
+        REQUIRE(data.type(JsonPath({})) == DataType::Object);
+        REQUIRE(data.size(JsonPath({})) == data.size());
+    }
+
+    SECTION("it gets the type and size of entries") {
+        REQUIRE(data.type(vec_path) == DataType::Int);
+        REQUIRE(data.type(JsonPath({ "vec" })) == DataType::Array);
+        REQUIRE(data.size(JsonPath({ "vec" })) == 2);
+        REQUIRE(data.size(JsonPath({ "nested" })) == 1);
+    }
+
+    SECTION("it checks whether entries exist") {
+        REQUIRE(data.includes(vec_path));
+        REQUIRE(data.includes(nested_path));
+        REQUIRE_FALSE(data.includes(JsonPath({ "vec", 2 })));
+        REQUIRE_FALSE(data.includes(JsonPath({ "missing" })));
+        REQUIRE_FALSE(data.includes(JsonPath({ "goo", "foo" })));
+        REQUIRE_FALSE(data.includes(JsonPath({ "nested", 0 })));
+    }
+
+    SECTION("it throws in case of missing or mismatched entries") {
+        REQUIRE_THROWS_AS(data.get<int>(JsonPath({ "missing" })), data_key_error);
+        REQUIRE_THROWS_AS(data.get<int>(JsonPath({ "vec", 2 })), data_index_error);
+        REQUIRE_THROWS_AS(data.get<int>(JsonPath({ "nested", 0 })), data_type_error);
+        REQUIRE_THROWS_AS(data.get<int>(JsonPath({ "goo", "foo" })), data_type_error);
+        REQUIRE_THROWS_AS(data.get<int>(nested_path), data_type_error);
+    }
+
+    SECTION("it sets entries, adding missing keys") {
+        data.set<int>(vec_path, 5);
+        REQUIRE(data.get<std::vector<int>>("vec") == (std::vector<int> { 1, 5 }));
+        data.set<std::string>(JsonPath({ "new", "entry" }), "value");
+        REQUIRE(data.get<std::string>({ "new", "entry" }) == "value");
+        REQUIRE_THROWS_AS(data.set<int>(JsonPath({ "goo", "foo" }), 1), data_key_error);
+        REQUIRE_THROWS_AS(data.set<int>(JsonPath({ "vec", 2 }), 1), data_index_error);
+    }
+
+    SECTION("it finds keys in documents with another layout") {
+        REQUIRE(data.get<std::string>(nested_path) == "bar");
+        JsonContainer other { "{\"nested\" : {\"a\" : 1, \"b\" : 2, \"foo\" : \"baz\"}}" };
+        REQUIRE(other.get<std::string>(nested_path) == "baz");
+        REQUIRE(data.get<std::string>(nested_path) == "bar");
+        JsonContainer prefix { "{\"nested\" : {\"fo\" : 1, \"foo\" : \"qux\"}}" };
+        REQUIRE(prefix.get<std::string>(nested_path) == "qux");
+    }
+
+    SECTION("it looks up paths in a view") {
+        JsonView view { data };
+        REQUIRE(view.get<int>(vec_path) == 2);
+        REQUIRE(view.type(nested_path) == DataType::String);
+        REQUIRE(view.size(JsonPath({ "vec" })) == 2);
+        REQUIRE(view.includes(nested_path));
+        REQUIRE(data.get<JsonView>("nested").get<std::string>(JsonPath({ "foo" })) == "bar");
+    }
+}
+
+TEST_CASE("JsonContainer::indexObjects", "[data]") {
+    JsonContainer data {};
+    data.indexObjects(4);
+
+    for (int i = 0; i < 100; ++i) {
+        data.set<int>("key" + std::to_string(i), i);
+    }
+
+    SECTION("it builds large objects with unique keys") {
+        REQUIRE(data.size() == 100);
+        data.set<int>("key50", -1);
+        REQUIRE(data.size() == 100);
+        REQUIRE(data.get<int>("key50") == -1);
+    }
+
+    SECTION("it looks up keys of large objects") {
+        REQUIRE(data.get<int>("key0") == 0);
+        REQUIRE(data.get<int>("key99") == 99);
+        REQUIRE(data.includes("key42"));
+        REQUIRE_FALSE(data.includes("key100"));
+        REQUIRE(data.getWithDefault<int>("key100", 7) == 7);
+        REQUIRE_THROWS_AS(data.get<int>("key100"), data_key_error);
+        REQUIRE(data.type(JsonPath({ "key7" })) == DataType::Int);
+    }
+
+    SECTION("it looks up keys added after the index was built") {
+        REQUIRE(data.get<int>("key1") == 1);
+        data.set<int>("late", 1000);
+        REQUIRE(data.get<int>("late") == 1000);
+        REQUIRE(data.includes(JsonPath({ "late" })));
+    }
+
+    SECTION("it looks up replaced objects") {
+        JsonContainer nested {};
+        for (int i = 0; i < 10; ++i) {
+            nested.set<int>("n" + std::to_string(i), i);
+        }
+        data.set<JsonContainer>("nested", nested);
+        REQUIRE(data.get<int>({ "nested", "n3" }) == 3);
+
+        JsonContainer other {};
+        for (int i = 0; i < 10; ++i) {
+            other.set<int>("o" + std::to_string(i), i);
+        }
+        data.set<JsonContainer>("nested", std::move(other));
+        REQUIRE_FALSE(data.includes({ "nested", "n3" }));
+        REQUIRE(data.get<int>({ "nested", "o3" }) == 3);
+
+        data.set<int>({ "nested", "o3" }, 30);
+        REQUIRE(data.get<int>({ "nested", "o3" }) == 30);
+        REQUIRE(data.size("nested") == 10);
+    }
+
+    SECTION("it looks up objects moved by the growth of their parent") {
+        JsonContainer parent {};
+        parent.indexObjects(2);
+        for (int i = 0; i < 20; ++i) {
+            auto key = "child" + std::to_string(i);
+            for (int j = 0; j < 3; ++j) {
+                parent.set<int>({ key, "k" + std::to_string(j) }, i * 10 + j);
+            }
+            REQUIRE(parent.get<int>({ key, "k2" }) == i * 10 + 2);
+        }
+        for (int i = 0; i < 20; ++i) {
+            REQUIRE(parent.get<int>({ "child" + std::to_string(i), "k1" }) == i * 10 + 1);
+        }
+    }
+
+    SECTION("it finds the first of duplicate keys, as without an index") {
+        data.parse("{\"a\" : 1, \"b\" : 2, \"c\" : 3, \"a\" : 4, \"d\" : 5}");
+        REQUIRE(data.get<int>("a") == 1);
+        REQUIRE(data.get<int>("d") == 5);
+        REQUIRE_FALSE(data.includes("key1"));
+    }
+
+    SECTION("it keeps the index when moved") {
+        JsonContainer moved { std::move(data) };
+        REQUIRE(moved.get<int>("key10") == 10);
+        moved.set<int>("key10", 11);
+        REQUIRE(moved.get<int>("key10") == 11);
+        REQUIRE(moved.size() == 100);
+    }
+}
+
+TEST_CASE("JsonContainer::eachMember", "[data]") {
+    JsonContainer data { JSON };
+
+    SECTION("it visits each member in order") {
+        std::vector<std::string> keys;
+        REQUIRE(data.eachMember([&](boost::string_ref key, const JsonView& value) {
+            keys.push_back(key.to_string());
+            if (key == "goo") {
+                REQUIRE(value.get<int>() == 1);
+            }
+            return true;
+        }));
+        REQUIRE(keys == data.keys());
+    }
+
+    SECTION("it stops when the callback returns false") {
+        size_t count = 0;
+        REQUIRE_FALSE(data.eachMember([&](boost::string_ref, const JsonView&) {
+            return ++count < 3;
+        }));
+        REQUIRE(count == 3);
+    }
+
+    SECTION("it throws a data_type_error if the root is not an object") {
+        JsonContainer array { "[1, 2]" };
+        REQUIRE_THROWS_AS(array.eachMember([](boost::string_ref, const JsonView&) { return true; }),
+                          data_type_error);
+    }
+}
+
+TEST_CASE("JsonContainer::eachElement", "[data]") {
+    JsonContainer data { "[1, 2, 3, 4]" };
+
+    SECTION("it visits each element in order") {
+        int sum = 0;
+        REQUIRE(data.eachElement([&](const JsonView& element) {
+            sum = sum * 10 + element.get<int>();
+            return true;
+        }));
+        REQUIRE(sum == 1234);
+    }
+
+    SECTION("it stops when the callback returns false") {
+        std::vector<int> elements;
+        REQUIRE_FALSE(data.eachElement([&](const JsonView& element) {
+            elements.push_back(element.get<int>());
+            return element.get<int>() < 2;
+        }));
+        REQUIRE(elements == (std::vector<int> { 1, 2 }));
+    }
+
+    SECTION("it throws a data_type_error if the root is not an array") {
+        REQUIRE_THROWS_AS(JsonContainer { JSON }.eachElement([](const JsonView&) { return true; }),
+                          data_type_error);
+    }
+
+    SECTION("it visits the elements of a viewed array") {
+        JsonContainer object { JSON };
+        std::vector<std::string> strings;
+        object.get<JsonView>("string_vec").eachElement([&](const JsonView& element) {
+            strings.push_back(element.get<std::string>());
+            return true;
+        });
+        REQUIRE(strings == object.get<std::vector<std::string>>("string_vec"));
+    }
+}
+
+TEST_CASE("JsonView::members", "[data]") {
+    JsonContainer data { JSON };
+
+    SECTION("it iterates over the members of an object") {
+        std::vector<std::string> keys;
+        for (auto member : JsonView { data }.members()) {
+            keys.push_back(member.key.to_string());
+            if (member.key == "nested") {
+                REQUIRE(member.value.get<std::string>("foo") == "bar");
+            }
+        }
+        REQUIRE(keys == data.keys());
+    }
+
+    SECTION("it iterates over an empty object") {
+        JsonContainer empty {};
+        auto members = JsonView { empty }.members();
+        REQUIRE(members.begin() == members.end());
+    }
+
+    SECTION("it throws a data_type_error if the viewed entry is not an object") {
+        REQUIRE_THROWS_AS(data.get<JsonView>("vec").members(), data_type_error);
+    }
+}
@@ -0,0 +1,156 @@
+#include <catch.hpp>
+#include <leatherman/json_container/json_reader.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/nowide/fstream.hpp>
+#include <fcntl.h>
+#include <sstream>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+using namespace leatherman::json_container;
+
+static const std::string REPORT = "{\"data\" : {\"facts\" : {\"os\" : \"linux\", \"cores\" : 4},"
+                                  "           \"resources\" : [{\"title\" : \"a\"}, {\"title\" : \"b\"}, 3]},"
+                                  " \"name\" : \"node\","
+                                  " \"big\" : 18446744073709551615}";
+
+TEST_CASE("JsonReader::onEvent", "[data]") {
+    JsonReader reader {};
+    std::vector<JsonEvent> events;
+    std::vector<std::string> strings;
+    reader.onEvent([&](const JsonEvent& event) {
+        events.push_back(event);
+        strings.push_back(event.string_value.to_string());
+        return true;
+    });
+
+    SECTION("it emits typed events") {
+        REQUIRE(reader.read("{\"a\" : [1, 2.5, true, null, \"s\"]}"));
+        REQUIRE(events.size() == 10);
+        REQUIRE(events[0].type == JsonEventType::StartObject);
+        REQUIRE(events[0].depth == 0);
+        REQUIRE(events[1].type == JsonEventType::Key);
+        REQUIRE(strings[1] == "a");
+        REQUIRE(events[2].type == JsonEventType::StartArray);
+        REQUIRE(events[2].depth == 1);
+        REQUIRE(events[3].type == JsonEventType::Int);
+        REQUIRE(events[3].int_value == 1);
+        REQUIRE(events[3].depth == 2);
+        REQUIRE(events[4].type == JsonEventType::Double);
+        REQUIRE(events[4].double_value == 2.5);
+        REQUIRE(events[5].type == JsonEventType::Bool);
+        REQUIRE(events[5].bool_value);
+        REQUIRE(events[6].type == JsonEventType::Null);
+        REQUIRE(events[7].type == JsonEventType::String);
+        REQUIRE(strings[7] == "s");
+        REQUIRE(events[8].type == JsonEventType::EndArray);
+        REQUIRE(events[8].depth == 1);
+        REQUIRE(events[9].type == JsonEventType::EndObject);
+        REQUIRE(events[9].depth == 0);
+    }
+
+    SECTION("it stops when the callback returns false") {
+        reader.onEvent([&](const JsonEvent& event) {
+            events.push_back(event);
+            return event.type != JsonEventType::Key;
+        });
+        REQUIRE_FALSE(reader.read(REPORT));
+        REQUIRE(events.size() == 2);
+    }
+
+    SECTION("it throws a data_parse_error in case of invalid JSON") {
+        REQUIRE_THROWS_AS(reader.read("{\"a\" : [1, 2}"), data_parse_error);
+    }
+}
+
+TEST_CASE("JsonReader::select", "[data]") {
+    JsonReader reader {};
+    std::vector<JsonContainer> entries;
+    auto keep = [&](JsonContainer& entry) {
+        entries.push_back(std::move(entry));
+        return true;
+    };
+
+    SECTION("it builds the selected entries only") {
+        reader.select({ "data", "facts" }, keep);
+        reader.select({ "name" }, keep);
+        reader.select({ "missing" }, keep);
+        REQUIRE(reader.read(REPORT));
+        REQUIRE(entries.size() == 2);
+        REQUIRE(entries[0].get<std::string>("os") == "linux");
+        REQUIRE(entries[0].get<int>("cores") == 4);
+        REQUIRE(entries[1].get<std::string>() == "node");
+    }
+
+    SECTION("it can select the root") {
+        reader.select({}, keep);
+        REQUIRE(reader.read(REPORT));
+        REQUIRE(entries.size() == 1);
+        REQUIRE(entries[0].toString() == JsonContainer { REPORT }.toString());
+    }
+
+    SECTION("it can select each element of an array") {
+        reader.selectEach({ "data", "resources" }, keep);
+        REQUIRE(reader.read(REPORT));
+        REQUIRE(entries.size() == 3);
+        REQUIRE(JsonView { entries[1] }.get<std::string>("title") == "b");
+        REQUIRE(entries[2].get<int>() == 3);
+    }
+
+    SECTION("it can select each element of the root array") {
+        reader.selectEach({}, keep);
+        REQUIRE(reader.read("[{\"a\" : [1, {\"b\" : []}]}, \"s\", [true]]"));
+        REQUIRE(entries.size() == 3);
+        REQUIRE(entries[0].toString() == "{\"a\":[1,{\"b\":[]}]}");
+        REQUIRE(entries[1].get<std::string>() == "s");
+        REQUIRE(entries[2].get<std::vector<bool>>() == std::vector<bool> { true });
+    }
+
+    SECTION("it stops when the callback returns false") {
+        reader.selectEach({ "data", "resources" }, [&](JsonContainer& entry) {
+            entries.push_back(std::move(entry));
+            return false;
+        });
+        REQUIRE_FALSE(reader.read(REPORT));
+        REQUIRE(entries.size() == 1);
+    }
+}
+
+TEST_CASE("JsonReader::read", "[data]") {
+    // A small buffer, so the input is read in many chunks
+    JsonReader reader { 7 };
+    std::vector<std::string> titles;
+    reader.selectEach({ "data", "resources" }, [&](JsonContainer& entry) {
+        titles.push_back(entry.type() == DataType::Object ? entry.get<std::string>("title") : "");
+        return true;
+    });
+
+    SECTION("it reads from a stream") {
+        std::istringstream in { REPORT };
+        REQUIRE(reader.read(in));
+        REQUIRE(titles == (std::vector<std::string> { "a", "b", "" }));
+    }
+
+    SECTION("it reads from a file descriptor") {
+        auto path = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("lth_json_reader_%%%%-%%%%");
+        {
+            boost::nowide::ofstream out(path.string().c_str());
+            out << REPORT;
+        }
+        int fd = open(path.string().c_str(), O_RDONLY);
+        REQUIRE(fd >= 0);
+        REQUIRE(reader.read(fd));
+        close(fd);
+        boost::filesystem::remove(path);
+        REQUIRE(titles == (std::vector<std::string> { "a", "b", "" }));
+    }
+
+    SECTION("it throws a data_parse_error in case of truncated input") {
+        std::istringstream in { REPORT.substr(0, 60) };
+        REQUIRE_THROWS_AS(reader.read(in), data_parse_error);
+    }
+}
@@ -10,11 +10,22 @@ namespace leatherman { namespace locale {
         throw runtime_error("leatherman::locale::get_locale is not supported on this platform");
     }
 
+    std::locale const& get_locale_ref(string const& id, string const& domain, vector<string> const& paths)
+    {
+        // std::locale is not supported on these platforms
+        throw runtime_error("leatherman::locale::get_locale_ref is not supported on this platform");
+    }
+
     void clear_domain(string const& domain)
     {
         throw runtime_error("leatherman::locale::clear_domain is not supported on this platform");
     }
 
+    void use_mapped_catalogs(bool enabled)
+    {
+        // There are no catalogs to map.
+    }
+
     string translate(string const& msg, string const& domain)
     {
         return msg;
@@ -9,10 +9,13 @@
 * on matching a string, specify that both "%N%" (Boost.Format) and "{N}"
 * (Boost.Locale) should be considered substitution characters when using
 * leatherman::locale::format, and "{N}" should be preferred. When i18n is
-* disabled, it will regex replace "{(\d+)}" to "%\1%" for use with Boost.Format.
+* disabled, "{N}" is substituted directly; format strings using "%N%" are
+* passed to Boost.Format after replacing "{(\d+)}" with "%\1%".
 */
 #pragma once
 #include <locale>
+#include <ostream>
+#include <string>
 #include <vector>
 #include <functional>
 
@@ -29,6 +32,15 @@
 #define PROJECT_DIR
 #endif
 
+/**
+ * Translates and formats a format string literal, like leatherman::locale::format, and fails to
+ * compile if the number of arguments doesn't match the highest "{N}" placeholder in the literal.
+ * @param fmt The format string literal.
+ * @param ... The format arguments.
+ */
+#define LEATHERMAN_FORMAT(fmt, ...) \
+    leatherman::locale::format_literal<leatherman::locale::highest_placeholder(fmt)>(fmt, ##__VA_ARGS__)
+
 namespace leatherman { namespace locale {
 
     /**
@@ -48,12 +60,38 @@ namespace leatherman { namespace locale {
                                  std::vector<std::string> const& paths = {PROJECT_DIR});
 
     /**
-     * Clears the locale for a specific domain.
-     * WARNING: This may invalidate existing references, so only use for testing.
+     * Gets a reference to the locale for the specified domain, creating it if needed, without copying it.
+     * Once a domain's locale exists this doesn't lock, and if several threads create the same domain's
+     * locale at once it's only created once. The reference remains valid until the process exits.
+     * @param id The locale ID, defaults to a UTF-8 compatible system default.
+     * @param domain The catalog domain to use for i18n via gettext.
+     * @param paths Search paths for localization files.
+     * @return The locale. If a locale for the specified domain already exists, it returns
+     * the same locale until clear_domain is called for that domain.
+     * Throws boost::locale::conv::conversion_error under the same conditions as get_locale.
+     */
+    std::locale const& get_locale_ref(std::string const& id = "",
+                                      std::string const& domain = PROJECT_NAME,
+                                      std::vector<std::string> const& paths = {PROJECT_DIR});
+
+    /**
+     * Clears the locale and cached translations for a specific domain.
+     * Later calls create a new locale; the old one is kept so existing references stay valid,
+     * so only use for testing.
      * @param domain The catalog domain to clear.
      */
     void clear_domain(std::string const& domain = PROJECT_NAME);
 
+    /**
+     * Selects whether translations are looked up in memory mapped message catalogs rather than
+     * catalogs loaded by Boost.Locale. A mapped catalog isn't read until the first lookup, and isn't
+     * found at all for English, so programs that never translate anything don't pay to load it.
+     * Only UTF-8 catalogs are mapped; others are still loaded by Boost.Locale.
+     * Applies to domains whose locale hasn't been created yet.
+     * @param enabled True to map catalogs, or false to load them with Boost.Locale (the default).
+     */
+    void use_mapped_catalogs(bool enabled = true);
+
     /**
      * Translate text using the locale initialized by this library.
      * If localization encounters an error, the original message will be returned.
@@ -100,36 +138,191 @@ namespace leatherman { namespace locale {
      */
     std::string translate_np(std::string const& context, std::string const& single, std::string const& plural, int n, std::string const& domain = PROJECT_NAME);
 
+    /**
+     * Substitutes arguments for "{N}" placeholders without going through Boost.Format.
+     * Arguments are rendered into a single buffer as they're added, and each format string
+     * is parsed once per thread and cached, so repeated messages aren't scanned again.
+     */
+    class positional_formatter
+    {
+     public:
+        /**
+         * Renders an argument with its stream insertion operator, as Boost.Format would.
+         * @param arg The argument to add.
+         */
+        template <typename T>
+        void add(T const& arg)
+        {
+            stream_target target(_arguments);
+            target.stream() << arg;
+            _ends.push_back(_arguments.size());
+        }
+
+        /**
+         * Adds a string argument.
+         * @param arg The argument to add.
+         */
+        void add(std::string const& arg);
+
+        /**
+         * Adds a string argument.
+         * @param arg The argument to add.
+         */
+        void add(char const* arg);
+
+        /**
+         * Substitutes the added arguments into a format string. "{N}" refers to the Nth argument;
+         * any formatting options in "{N,...}" are ignored. Other braces are copied as they are.
+         * @param fmt The format string.
+         * @param result The formatted string is appended to this if the format string is supported.
+         * @return Returns false if the format string contains "%" directives, which need Boost.Format,
+         * or doesn't refer to exactly the arguments added. Otherwise returns true.
+         */
+        bool format(std::string const& fmt, std::string& result) const;
+
+        /**
+         * Substitutes the added arguments into the translation of a string literal. If the literal
+         * wasn't translated, its parse is cached by address rather than by its contents.
+         * @param literal The untranslated format string literal.
+         * @param fmt The translated format string.
+         * @param result The formatted string is appended to this if the format string is supported.
+         * @return Returns true if the format string is supported, as for format.
+         */
+        bool format_literal(char const* literal, std::string const& fmt, std::string& result) const;
+
+     private:
+        /**
+         * Points the calling thread's argument stream at a buffer for the lifetime of the object.
+         * The previous buffer is restored on destruction, so formatting can nest.
+         */
+        class stream_target
+        {
+         public:
+            explicit stream_target(std::string& buffer);
+            ~stream_target();
+            stream_target(stream_target const&) = delete;
+            stream_target& operator=(stream_target const&) = delete;
+            std::ostream& stream();
+
+         private:
+            std::string* _previous;
+        };
+
+        std::string _arguments;
+        std::vector<size_t> _ends;
+    };
+
+    namespace {
+        /*
+         * Compile-time scanning of format string literals. Each function splits its range in half,
+         * so the recursion depth grows with the log of the string's length.
+         */
+
+        constexpr bool is_digit(char c)
+        {
+            return c >= '0' && c <= '9';
+        }
+
+        constexpr bool contains(char const* fmt, size_t begin, size_t end, char c)
+        {
+            return end - begin == 0 ? false :
+                   end - begin == 1 ? fmt[begin] == c :
+                   contains(fmt, begin, begin + (end - begin) / 2, c) || contains(fmt, begin + (end - begin) / 2, end, c);
+        }
+
+        // Parses the digits of a placeholder, returning its number if it's properly terminated or 0 if not.
+        constexpr int placeholder_number(char const* fmt, size_t pos, size_t end, int value)
+        {
+            return pos < end && is_digit(fmt[pos]) && value < 10000 ? placeholder_number(fmt, pos + 1, end, value * 10 + (fmt[pos] - '0')) :
+                   pos < end && fmt[pos] == '}' ? value :
+                   pos < end && fmt[pos] == ',' && contains(fmt, pos, end, '}') ? value :
+                   0;
+        }
+
+        constexpr int placeholder_at(char const* fmt, size_t pos, size_t end)
+        {
+            return fmt[pos] == '{' && pos + 1 < end && is_digit(fmt[pos + 1]) ? placeholder_number(fmt, pos + 1, end, 0) : 0;
+        }
+
+        constexpr int max_of(int a, int b)
+        {
+            return a > b ? a : b;
+        }
+
+        constexpr int highest_placeholder_in(char const* fmt, size_t begin, size_t end, size_t size)
+        {
+            return end - begin == 0 ? 0 :
+                   end - begin == 1 ? placeholder_at(fmt, begin, size) :
+                   max_of(highest_placeholder_in(fmt, begin, begin + (end - begin) / 2, size),
+                          highest_placeholder_in(fmt, begin + (end - begin) / 2, end, size));
+        }
+    }
+
+    /**
+     * Finds the highest numbered "{N}" placeholder in a format string literal at compile time.
+     * @param fmt The format string literal.
+     * @return Returns the highest placeholder number, 0 if there are none, or -1 if the format
+     * string uses "%" directives, which can't be checked.
+     */
+    template <size_t N>
+    constexpr int highest_placeholder(char const (&fmt)[N])
+    {
+        return contains(fmt, 0, N - 1, '%') ? -1 : highest_placeholder_in(fmt, 0, N - 1, N - 1);
+    }
+
     namespace {
         /*
          * Anonymous namespace, limiting access to current namespace
          */
 
         /**
-         * Translates and formats text using boost::regex and boost::format.
+         * Translates and formats text without localization, using positional_formatter
+         * or boost::format for format strings it doesn't support.
+         * @param buffer The buffer to append the formatted text to.
          * @param trans The translation function.
          * @param domain Domain name.
          * @param args Format arguments.
-         * @return The string generated by translating the format string, then applying the arguments.
          */
-        template <typename... TArgs>
-        std::string format_disabled_locales(std::function<std::string(const std::string&)>&& trans, std::string domain, TArgs... args) {
-            // When locales are disabled, use boost::format, which expects %N% style formatting
+        template <typename Translate, typename... TArgs>
+        void format_disabled_locales_to(std::string& buffer, Translate const& trans, std::string const& domain, TArgs const&... args) {
+            auto fmt = trans(domain);
+            positional_formatter formatter;
+            (void) std::initializer_list<int>{ ((void)formatter.add(args), 0)... };
+            if (formatter.format(fmt, buffer)) {
+                return;
+            }
+
+            // Otherwise use boost::format, which expects %N% style formatting and reports
+            // mismatched arguments.
             static const boost::regex match{"\\{(\\d+)\\}"};
             static const std::string repl{"%\\1%"};
-            boost::format form{boost::regex_replace(trans(domain), match, repl)};
+            boost::format form{boost::regex_replace(fmt, match, repl)};
             (void) std::initializer_list<int>{ ((void)(form % args), 0)... };
-            return form.str();
+            buffer += form.str();
         }
 
         /**
-         * Translates and formats text using the locale initialized by this library.
+         * Translates and formats text without localization.
          * @param trans The translation function.
+         * @param domain Domain name.
          * @param args Format arguments.
          * @return The string generated by translating the format string, then applying the arguments.
          */
-        template <typename... TArgs>
-        std::string format_common(std::function<std::string(const std::string&)>&& trans, TArgs... args)
+        template <typename Translate, typename... TArgs>
+        std::string format_disabled_locales(Translate&& trans, std::string domain, TArgs... args) {
+            std::string result;
+            format_disabled_locales_to(result, trans, domain, args...);
+            return result;
+        }
+
+        /**
+         * Translates and formats text using the locale initialized by this library.
+         * @param buffer The buffer to append the formatted text to.
+         * @param trans The translation function.
+         * @param args Format arguments.
+         */
+        template <typename Translate, typename... TArgs>
+        void format_common_to(std::string& buffer, Translate const& trans, TArgs const&... args)
         {
             // Create and apply formatter here, as we want to guarantee the lifetime of the arguments.
             // boost::locale::format doesn't make copies, and a common gotcha is using temporary arguments
@@ -140,14 +333,28 @@ namespace leatherman { namespace locale {
             boost::locale::format form{trans(domain)};
             (void) std::initializer_list<int>{ ((void)(form % args), 0)... };
             try {
-                return form.str(get_locale("", domain));
+                buffer += form.str(get_locale_ref("", domain));
             } catch (const std::exception &e) {
-                return format_disabled_locales(std::move(trans), domain, std::forward<TArgs>(args)...);
+                format_disabled_locales_to(buffer, trans, domain, args...);
             }
 #else
-            return format_disabled_locales(std::move(trans), domain, std::forward<TArgs>(args)...);
+            format_disabled_locales_to(buffer, trans, domain, args...);
 #endif
         }
+
+        /**
+         * Translates and formats text using the locale initialized by this library.
+         * @param trans The translation function.
+         * @param args Format arguments.
+         * @return The string generated by translating the format string, then applying the arguments.
+         */
+        template <typename Translate, typename... TArgs>
+        std::string format_common(Translate&& trans, TArgs... args)
+        {
+            std::string result;
+            format_common_to(result, trans, args...);
+            return result;
+        }
     }
 
     /**
@@ -179,6 +386,50 @@ namespace leatherman { namespace locale {
         return format(std::forward<decltype(fmt)>(fmt), std::forward<TArgs>(args)...);
     }
 
+    /**
+     * Translates and formats text using the locale initialized by this library, appending it to a buffer.
+     * Use the default domain, i.e. PROJECT_NAME.
+     * @param buffer The buffer to append the formatted text to.
+     * @param fmt The format string.
+     * @param args Format arguments.
+     */
+    template <typename... TArgs>
+    void format_to(std::string& buffer, std::string const& fmt, TArgs&&... args)
+    {
+        auto trans = [&fmt](const std::string& domain) {return translate(fmt, domain);};
+        format_common_to(buffer, trans, std::forward<TArgs>(args)...);
+    }
+
+    /**
+     * Translates and formats a format string literal whose placeholders have been counted at compile time.
+     * Use the LEATHERMAN_FORMAT macro rather than calling this directly.
+     * @tparam Placeholders The highest placeholder in the format string, or -1 if it wasn't checked.
+     * @param fmt The format string literal.
+     * @param args Format arguments.
+     * @return The string generated by translating the format string, then applying the arguments.
+     */
+    template <int Placeholders, size_t N, typename... TArgs>
+    std::string format_literal(char const (&fmt)[N], TArgs&&... args)
+    {
+        static_assert(Placeholders < 0 || Placeholders == sizeof...(TArgs),
+                      "the number of format arguments doesn't match the placeholders in the format string");
+#ifdef LEATHERMAN_I18N
+        return format(fmt, std::forward<TArgs>(args)...);
+#else
+        static const std::string domain{PROJECT_NAME};
+        auto translated = translate(fmt, domain);
+        positional_formatter formatter;
+        (void) std::initializer_list<int>{ ((void)formatter.add(args), 0)... };
+        std::string result;
+        if (formatter.format_literal(fmt, translated, result)) {
+            return result;
+        }
+        auto trans = [&translated](const std::string&) {return translated;};
+        format_disabled_locales_to(result, trans, domain, args...);
+        return result;
+#endif
+    }
+
     /**
      * Translates and formats text in a given context using the locale initialized by this library.
      * Use the default domain, i.e. PROJECT_NAME.
@@ -210,6 +461,22 @@ namespace leatherman { namespace locale {
         return format_p(std::forward<decltype(context)>(context), std::forward<decltype(fmt)>(fmt), std::forward<TArgs>(args)...);
     }
 
+    /**
+     * Translates and formats text in a given context using the locale initialized by this library,
+     * appending it to a buffer.
+     * Use the default domain, i.e. PROJECT_NAME.
+     * @param buffer The buffer to append the formatted text to.
+     * @param context The context string.
+     * @param fmt The format string.
+     * @param args Format arguments.
+     */
+    template <typename... TArgs>
+    void format_p_to(std::string& buffer, std::string const& context, std::string const& fmt, TArgs&&... args)
+    {
+        auto trans = [&context, &fmt](const std::string& domain) {return translate_p(context, fmt, domain);};
+        format_common_to(buffer, trans, std::forward<TArgs>(args)...);
+    }
+
     /**
      * Translates and formats plural text using the locale initialized by this library.
      * Use the default domain, i.e. PROJECT_NAME.
@@ -243,6 +510,22 @@ namespace leatherman { namespace locale {
         return format_n(std::forward<decltype(single)>(single), std::forward<decltype(plural)>(plural), std::forward<decltype(n)>(n), std::forward<TArgs>(args)...);
     }
 
+    /**
+     * Translates and formats plural text using the locale initialized by this library, appending it to a buffer.
+     * Use the default domain, i.e. PROJECT_NAME.
+     * @param buffer The buffer to append the formatted text to.
+     * @param single The singular format string.
+     * @param plural The plural format string.
+     * @param n Number of items, used to choose singular or plural.
+     * @param args Format arguments.
+     */
+    template <typename... TArgs>
+    void format_n_to(std::string& buffer, std::string const& single, std::string const& plural, int n, TArgs&&... args)
+    {
+        auto trans = [&single, &plural, n](const std::string& domain) {return translate_n(single, plural, n, domain);};
+        format_common_to(buffer, trans, std::forward<TArgs>(args)...);
+    }
+
     /**
      * Translates and formats plural text in a given context using the locale initialized by this library.
      * Replaces the use of boost::format with a variadic function call.
@@ -277,4 +560,22 @@ namespace leatherman { namespace locale {
     {
         return format_np(std::forward<decltype(context)>(context), std::forward<decltype(single)>(single), std::forward<decltype(plural)>(plural), std::forward<decltype(n)>(n), std::forward<TArgs>(args)...);
     }
+
+    /**
+     * Translates and formats plural text in a given context using the locale initialized by this library,
+     * appending it to a buffer.
+     * Use the default domain, i.e. PROJECT_NAME.
+     * @param buffer The buffer to append the formatted text to.
+     * @param context The context string.
+     * @param single The singular format string.
+     * @param plural The plural format string.
+     * @param n Number of items, used to choose singular or plural.
+     * @param args Format arguments.
+     */
+    template <typename... TArgs>
+    void format_np_to(std::string& buffer, std::string const& context, std::string const& single, std::string const& plural, int n, TArgs&&... args)
+    {
+        auto trans = [&context, &single, &plural, n](const std::string& domain) {return translate_np(context, single, plural, n, domain);};
+        format_common_to(buffer, trans, std::forward<TArgs>(args)...);
+    }
 }}  // namespace leatherman::locale
@@ -0,0 +1,523 @@
+#include "catalog.hpp"
+#include <boost/algorithm/string.hpp>
+#include <boost/filesystem.hpp>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+
+namespace leatherman { namespace locale {
+
+    using namespace std;
+    namespace ip = boost::interprocess;
+
+    static constexpr uint32_t mo_magic = 0x950412de;
+    static constexpr uint32_t mo_magic_swapped = 0xde120495;
+
+    // The hash function gettext uses for .mo hash tables.
+    static uint64_t hash_string(string const& str)
+    {
+        uint64_t hval = 0;
+        for (unsigned char c : str) {
+            hval <<= 4;
+            hval += c;
+            uint64_t g = hval & (~static_cast<uint64_t>(0) << 28);
+            if (g != 0) {
+                hval ^= g >> 24;
+                hval ^= g;
+            }
+        }
+        return hval;
+    }
+
+    unique_ptr<message_catalog> message_catalog::open(string const& path)
+    {
+        boost::system::error_code ec;
+        if (!boost::filesystem::is_regular_file(path, ec)) {
+            return nullptr;
+        }
+
+        unique_ptr<message_catalog> catalog(new message_catalog());
+        try {
+            catalog->_file = ip::file_mapping(path.c_str(), ip::read_only);
+            catalog->_region = ip::mapped_region(catalog->_file, ip::read_only);
+        } catch (ip::interprocess_exception const&) {
+            return nullptr;
+        }
+        catalog->_data = static_cast<char const*>(catalog->_region.get_address());
+        catalog->_size = catalog->_region.get_size();
+        if (!catalog->load()) {
+            return nullptr;
+        }
+        return catalog;
+    }
+
+    uint32_t message_catalog::word(size_t offset) const
+    {
+        uint32_t value;
+        memcpy(&value, _data + offset, sizeof(value));
+        if (_swap) {
+            value = ((value & 0xff) << 24) | ((value & 0xff00) << 8) | ((value >> 8) & 0xff00) | (value >> 24);
+        }
+        return value;
+    }
+
+    bool message_catalog::entry(size_t table, uint32_t index, char const*& data, uint32_t& length) const
+    {
+        // Each table entry is a length and an offset, and every string is followed by a NUL.
+        size_t descriptor = table + static_cast<size_t>(index) * 8;
+        if (descriptor + 8 > _size) {
+            return false;
+        }
+        length = word(descriptor);
+        uint32_t offset = word(descriptor + 4);
+        if (static_cast<size_t>(offset) + length >= _size || _data[offset + length] != '\0') {
+            return false;
+        }
+        data = _data + offset;
+        return true;
+    }
+
+    bool message_catalog::load()
+    {
+        if (_size < 28) {
+            return false;
+        }
+        uint32_t magic;
+        memcpy(&magic, _data, sizeof(magic));
+        if (magic == mo_magic_swapped) {
+            _swap = true;
+        } else if (magic != mo_magic) {
+            return false;
+        }
+        // Only major revision 0 is understood; minor revisions add optional data.
+        if ((word(4) >> 16) != 0) {
+            return false;
+        }
+        _count = word(8);
+        _originals = word(12);
+        _translations = word(16);
+        _hash_size = word(20);
+        _hash_table = word(24);
+        if (static_cast<uint64_t>(_originals) + static_cast<uint64_t>(_count) * 8 > _size ||
+            static_cast<uint64_t>(_translations) + static_cast<uint64_t>(_count) * 8 > _size ||
+            static_cast<uint64_t>(_hash_table) + static_cast<uint64_t>(_hash_size) * 4 > _size) {
+            return false;
+        }
+        if (_hash_size < 3) {
+            _hash_size = 0;
+        }
+
+        // The translation of the empty string is the catalog's header.
+        char const* header;
+        uint32_t length;
+        if (!lookup(string(), header, length)) {
+            return true;
+        }
+        string headers(header, length);
+
+        // Translations are returned as they're stored, so only accept UTF-8 catalogs.
+        auto charset = headers.find("charset=");
+        if (charset != string::npos) {
+            auto end = headers.find_first_of(" ;\n", charset);
+            auto name = headers.substr(charset + 8, end == string::npos ? string::npos : end - charset - 8);
+            if (!boost::iequals(name, "UTF-8") && !boost::iequals(name, "UTF8") && !boost::iequals(name, "ASCII")) {
+                return false;
+            }
+        }
+
+        auto forms = headers.find("Plural-Forms:");
+        if (forms != string::npos) {
+            auto end = headers.find('\n', forms);
+            auto line = headers.substr(forms, end == string::npos ? string::npos : end - forms);
+            auto nplurals = line.find("nplurals=");
+            auto plural = line.find("plural=", nplurals == string::npos ? 0 : nplurals + 9);
+            if (nplurals != string::npos) {
+                _plural_count = strtoul(line.c_str() + nplurals + 9, nullptr, 10);
+            }
+            if (plural != string::npos) {
+                auto expression = line.substr(plural + 7);
+                auto semicolon = expression.find(';');
+                if (semicolon != string::npos) {
+                    expression.resize(semicolon);
+                }
+                if (!parse_plural(expression, _plural)) {
+                    _plural.clear();
+                }
+            }
+        }
+        return true;
+    }
+
+    bool message_catalog::lookup(string const& key, char const*& data, uint32_t& length) const
+    {
+        char const* original;
+        uint32_t original_length;
+
+        if (_hash_size == 0) {
+            // No hash table, so binary search the originals, which msgfmt sorts.
+            uint32_t low = 0;
+            uint32_t high = _count;
+            while (low < high) {
+                uint32_t middle = low + (high - low) / 2;
+                if (!entry(_originals, middle, original, original_length)) {
+                    return false;
+                }
+                int compared = strcmp(key.c_str(), original);
+                if (compared == 0) {
+                    return entry(_translations, middle, data, length);
+                }
+                if (compared < 0) {
+                    high = middle;
+                } else {
+                    low = middle + 1;
+                }
+            }
+            return false;
+        }
+
+        auto hval = hash_string(key);
+        uint32_t index = static_cast<uint32_t>(hval % _hash_size);
+        uint32_t increment = 1 + static_cast<uint32_t>(hval % (_hash_size - 2));
+        // Bound the probes in case the table is corrupt and has no empty slot.
+        for (uint32_t probes = 0; probes < _hash_size; ++probes) {
+            uint32_t string_number = word(_hash_table + static_cast<size_t>(index) * 4);
+            if (string_number == 0 || string_number > _count) {
+                return false;
+            }
+            // Compare up to the first NUL, which ends the singular form of a plural message.
+            if (entry(_originals, string_number - 1, original, original_length) &&
+                strlen(original) == key.size() && memcmp(original, key.data(), key.size()) == 0) {
+                return entry(_translations, string_number - 1, data, length);
+            }
+            index = index >= _hash_size - increment ? index - (_hash_size - increment) : index + increment;
+        }
+        return false;
+    }
+
+    bool message_catalog::find(string const* context, string const& msg, string const* plural, int n, string& translation) const
+    {
+        char const* data;
+        uint32_t length;
+        bool found;
+        if (context) {
+            // Messages with a context are stored as the context, an EOT and the message.
+            string key;
+            key.reserve(context->size() + 1 + msg.size());
+            key += *context;
+            key += '\4';
+            key += msg;
+            found = lookup(key, data, length);
+        } else {
+            found = lookup(msg, data, length);
+        }
+        if (!found || length == 0) {
+            return false;
+        }
+
+        if (!plural) {
+            translation.assign(data, strnlen(data, length));
+            return true;
+        }
+
+        // The plural forms follow one another, separated by NULs.
+        unsigned long form = n == 1 ? 0 : 1;
+        if (!_plural.empty()) {
+            form = evaluate(_plural, _plural.size() - 1, static_cast<unsigned long>(n));
+        }
+        if (form >= _plural_count) {
+            form = 0;
+        }
+        char const* end = data + length;
+        for (; form > 0 && data < end; --form) {
+            data += strnlen(data, end - data) + 1;
+        }
+        if (data >= end) {
+            return false;
+        }
+        translation.assign(data, strnlen(data, end - data));
+        return true;
+    }
+
+    bool message_catalog::parse_plural(string const& expression, vector<plural_node>& nodes)
+    {
+        // A recursive descent parser for the subset of C used in plural expressions. Nodes are
+        // added after their operands, so the last node is the root.
+        struct parser
+        {
+            using kind = plural_node::kind;
+
+            string const& text;
+            vector<plural_node>& nodes;
+            size_t pos;
+            int depth;
+
+            void skip_space()
+            {
+                while (pos < text.size() && isspace(static_cast<unsigned char>(text[pos]))) {
+                    ++pos;
+                }
+            }
+
+            bool accept(char const* token)
+            {
+                skip_space();
+                auto length = strlen(token);
+                if (text.compare(pos, length, token) != 0) {
+                    return false;
+                }
+                // Don't mistake the start of "<=", ">=" or "!=" for a single character operator.
+                if (length == 1 && pos + 1 < text.size() && text[pos + 1] == '=' && strchr("<>!=", token[0])) {
+                    return false;
+                }
+                pos += length;
+                return true;
+            }
+
+            bool add(kind op, size_t first = 0, size_t second = 0, size_t third = 0, unsigned long value = 0)
+            {
+                nodes.push_back({ op, value, { first, second, third } });
+                return true;
+            }
+
+            bool binary(kind op, size_t left, bool (parser::*operand)())
+            {
+                if (!(this->*operand)()) {
+                    return false;
+                }
+                return add(op, left, nodes.size() - 1);
+            }
+
+            bool primary()
+            {
+                skip_space();
+                if (pos >= text.size()) {
+                    return false;
+                }
+                char c = text[pos];
+                if (c == 'n') {
+                    ++pos;
+                    return add(kind::n);
+                }
+                if (isdigit(static_cast<unsigned char>(c))) {
+                    unsigned long value = 0;
+                    while (pos < text.size() && isdigit(static_cast<unsigned char>(text[pos]))) {
+                        value = value * 10 + static_cast<unsigned long>(text[pos++] - '0');
+                    }
+                    return add(kind::number, 0, 0, 0, value);
+                }
+                if (c == '!') {
+                    ++pos;
+                    if (!primary()) {
+                        return false;
+                    }
+                    return add(kind::negate, nodes.size() - 1);
+                }
+                if (c == '(') {
+                    ++pos;
+                    if (!conditional()) {
+                        return false;
+                    }
+                    return accept(")");
+                }
+                return false;
+            }
+
+            bool multiplicative()
+            {
+                if (!primary()) {
+                    return false;
+                }
+                for (;;) {
+                    size_t left = nodes.size() - 1;
+                    kind op;
+                    if (accept("*")) {
+                        op = kind::multiply;
+                    } else if (accept("/")) {
+                        op = kind::divide;
+                    } else if (accept("%")) {
+                        op = kind::modulo;
+                    } else {
+                        return true;
+                    }
+                    if (!binary(op, left, &parser::primary)) {
+                        return false;
+                    }
+                }
+            }
+
+            bool additive()
+            {
+                if (!multiplicative()) {
+                    return false;
+                }
+                for (;;) {
+                    size_t left = nodes.size() - 1;
+                    kind op;
+                    if (accept("+")) {
+                        op = kind::add;
+                    } else if (accept("-")) {
+                        op = kind::subtract;
+                    } else {
+                        return true;
+                    }
+                    if (!binary(op, left, &parser::multiplicative)) {
+                        return false;
+                    }
+                }
+            }
+
+            bool relational()
+            {
+                if (!additive()) {
+                    return false;
+                }
+                for (;;) {
+                    size_t left = nodes.size() - 1;
+                    kind op;
+                    if (accept("<=")) {
+                        op = kind::less_equal;
+                    } else if (accept(">=")) {
+                        op = kind::greater_equal;
+                    } else if (accept("<")) {
+                        op = kind::less;
+                    } else if (accept(">")) {
+                        op = kind::greater;
+                    } else {
+                        return true;
+                    }
+                    if (!binary(op, left, &parser::additive)) {
+                        return false;
+                    }
+                }
+            }
+
+            bool equality()
+            {
+                if (!relational()) {
+                    return false;
+                }
+                for (;;) {
+                    size_t left = nodes.size() - 1;
+                    kind op;
+                    if (accept("==")) {
+                        op = kind::equal;
+                    } else if (accept("!=")) {
+                        op = kind::not_equal;
+                    } else {
+                        return true;
+                    }
+                    if (!binary(op, left, &parser::relational)) {
+                        return false;
+                    }
+                }
+            }
+
+            bool logical_and()
+            {
+                if (!equality()) {
+                    return false;
+                }
+                while (accept("&&")) {
+                    if (!binary(kind::logical_and, nodes.size() - 1, &parser::equality)) {
+                        return false;
+                    }
+                }
+                return true;
+            }
+
+            bool logical_or()
+            {
+                if (!logical_and()) {
+                    return false;
+                }
+                while (accept("||")) {
+                    if (!binary(kind::logical_or, nodes.size() - 1, &parser::logical_and)) {
+                        return false;
+                    }
+                }
+                return true;
+            }
+
+            bool conditional()
+            {
+                // Guard against expressions nested deeply enough to exhaust the stack.
+                if (++depth > 32) {
+                    return false;
+                }
+                if (!logical_or()) {
+                    return false;
+                }
+                if (accept("?")) {
+                    size_t condition = nodes.size() - 1;
+                    if (!conditional()) {
+                        return false;
+                    }
+                    size_t then = nodes.size() - 1;
+                    if (!accept(":") || !conditional()) {
+                        return false;
+                    }
+                    add(kind::conditional, condition, then, nodes.size() - 1);
+                }
+                --depth;
+                return true;
+            }
+        };
+
+        nodes.clear();
+        parser p{ expression, nodes, 0, 0 };
+        if (!p.conditional()) {
+            return false;
+        }
+        p.skip_space();
+        return p.pos == expression.size();
+    }
+
+    bool message_catalog::evaluate_plural(string const& expression, unsigned long n, unsigned long& form)
+    {
+        vector<plural_node> nodes;
+        if (!parse_plural(expression, nodes)) {
+            return false;
+        }
+        form = evaluate(nodes, nodes.size() - 1, n);
+        return true;
+    }
+
+    unsigned long message_catalog::evaluate(vector<plural_node> const& nodes, size_t index, unsigned long n)
+    {
+        auto const& node = nodes[index];
+        auto operand = [&](size_t i) { return evaluate(nodes, node.operands[i], n); };
+        using kind = plural_node::kind;
+        switch (node.op) {
+            case kind::number:        return node.value;
+            case kind::n:             return n;
+            case kind::negate:        return !operand(0);
+            case kind::multiply:      return operand(0) * operand(1);
+            case kind::divide:        { auto divisor = operand(1); return divisor == 0 ? 0 : operand(0) / divisor; }
+            case kind::modulo:        { auto divisor = operand(1); return divisor == 0 ? 0 : operand(0) % divisor; }
+            case kind::add:           return operand(0) + operand(1);
+            case kind::subtract:      return operand(0) - operand(1);
+            case kind::less:          return operand(0) < operand(1);
+            case kind::greater:       return operand(0) > operand(1);
+            case kind::less_equal:    return operand(0) <= operand(1);
+            case kind::greater_equal: return operand(0) >= operand(1);
+            case kind::equal:         return operand(0) == operand(1);
+            case kind::not_equal:     return operand(0) != operand(1);
+            case kind::logical_and:   return operand(0) && operand(1);
+            case kind::logical_or:    return operand(0) || operand(1);
+            case kind::conditional:   return operand(0) ? operand(1) : operand(2);
+        }
+        return 0;
+    }
+
+    void parse_locale_name(string const& name, string& language, string& country)
+    {
+        auto end = name.find_first_of("_.@");
+        language = name.substr(0, end);
+        country.clear();
+        if (end != string::npos && name[end] == '_') {
+            auto country_end = name.find_first_of(".@", end + 1);
+            country = name.substr(end + 1, country_end == string::npos ? string::npos : country_end - end - 1);
+        }
+    }
+
+}}  // namespace leatherman::locale
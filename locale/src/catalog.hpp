@@ -0,0 +1,94 @@
+#pragma once
+
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace leatherman { namespace locale {
+
+    /**
+     * A gettext message catalog (.mo file) that's memory mapped and searched in place,
+     * using the hash table msgfmt writes into the file.
+     */
+    class message_catalog
+    {
+     public:
+        /**
+         * Maps a catalog file.
+         * @param path The path to the .mo file.
+         * @return Returns the catalog, or nullptr if the file doesn't exist, isn't a valid catalog,
+         * or isn't encoded as UTF-8.
+         */
+        static std::unique_ptr<message_catalog> open(std::string const& path);
+
+        /**
+         * Looks up a translation.
+         * @param context The message context, or nullptr for none.
+         * @param msg The message, or its singular form.
+         * @param plural The plural form, or nullptr for a message without plurals.
+         * @param n The number used to choose a plural form.
+         * @param translation Set to the translation if found.
+         * @return Returns true if the catalog has a translation, or false if not.
+         */
+        bool find(std::string const* context, std::string const& msg, std::string const* plural, int n, std::string& translation) const;
+
+        /**
+         * Evaluates a catalog's plural expression.
+         * Exposed for testing; the expression is parsed with each call.
+         * @param expression The C expression from a catalog's Plural-Forms header, such as "(n != 1)".
+         * @param n The number of items.
+         * @param form Set to the index of the plural form to use.
+         * @return Returns true if the expression is valid, false otherwise.
+         */
+        static bool evaluate_plural(std::string const& expression, unsigned long n, unsigned long& form);
+
+     private:
+        message_catalog() = default;
+
+        bool load();
+        uint32_t word(size_t offset) const;
+        bool entry(size_t table, uint32_t index, char const*& data, uint32_t& length) const;
+        bool lookup(std::string const& key, char const*& data, uint32_t& length) const;
+
+        /**
+         * A node of a parsed plural expression; operands are indexes of other nodes.
+         */
+        struct plural_node
+        {
+            enum class kind { number, n, negate, multiply, divide, modulo, add, subtract,
+                              less, greater, less_equal, greater_equal, equal, not_equal,
+                              logical_and, logical_or, conditional };
+            kind op;
+            unsigned long value;
+            size_t operands[3];
+        };
+
+        static bool parse_plural(std::string const& expression, std::vector<plural_node>& nodes);
+        static unsigned long evaluate(std::vector<plural_node> const& nodes, size_t node, unsigned long n);
+
+        boost::interprocess::file_mapping _file;
+        boost::interprocess::mapped_region _region;
+        char const* _data = nullptr;
+        size_t _size = 0;
+        bool _swap = false;
+        uint32_t _count = 0;
+        uint32_t _originals = 0;
+        uint32_t _translations = 0;
+        uint32_t _hash_size = 0;
+        uint32_t _hash_table = 0;
+        unsigned long _plural_count = 2;
+        std::vector<plural_node> _plural;
+    };
+
+    /**
+     * Gets the language and country from a locale name such as "fr_FR.UTF-8@euro".
+     * @param name The locale name.
+     * @param language Set to the language, such as "fr".
+     * @param country Set to the country, such as "FR", or empty if there's none.
+     */
+    void parse_locale_name(std::string const& name, std::string& language, std::string& country);
+
+}}  // namespace leatherman::locale
@@ -0,0 +1,210 @@
+#include <leatherman/locale/locale.hpp>
+#include <unordered_map>
+
+namespace leatherman { namespace locale {
+
+    using namespace std;
+
+    /**
+     * A stream buffer that appends to a string, so arguments are rendered in place.
+     */
+    class appending_buffer : public streambuf
+    {
+     public:
+        string* target = nullptr;
+
+     protected:
+        int_type overflow(int_type c) override
+        {
+            if (!traits_type::eq_int_type(c, traits_type::eof())) {
+                target->push_back(traits_type::to_char_type(c));
+            }
+            return traits_type::not_eof(c);
+        }
+
+        streamsize xsputn(char const* s, streamsize count) override
+        {
+            target->append(s, static_cast<size_t>(count));
+            return count;
+        }
+    };
+
+    static thread_local appending_buffer t_buffer;
+    static thread_local ostream t_stream(&t_buffer);
+
+    positional_formatter::stream_target::stream_target(string& buffer) :
+        _previous(t_buffer.target)
+    {
+        t_buffer.target = &buffer;
+        // Each argument starts from the default stream state, as with boost::format.
+        t_stream.clear();
+        t_stream.flags(ios_base::dec | ios_base::skipws);
+        t_stream.width(0);
+        t_stream.precision(6);
+        t_stream.fill(' ');
+    }
+
+    positional_formatter::stream_target::~stream_target()
+    {
+        t_buffer.target = _previous;
+    }
+
+    ostream& positional_formatter::stream_target::stream()
+    {
+        return t_stream;
+    }
+
+    void positional_formatter::add(string const& arg)
+    {
+        _arguments += arg;
+        _ends.push_back(_arguments.size());
+    }
+
+    void positional_formatter::add(char const* arg)
+    {
+        if (arg) {
+            _arguments += arg;
+        }
+        _ends.push_back(_arguments.size());
+    }
+
+    /**
+     * A parsed format string. Literal pieces are offsets into the format string itself.
+     */
+    struct format_program
+    {
+        struct piece
+        {
+            size_t offset;
+            size_t length;
+            // The zero-based argument to substitute, or -1 for literal text.
+            int argument;
+        };
+
+        vector<piece> pieces;
+        size_t length = 0;
+        size_t arguments = 0;
+        bool supported = true;
+    };
+
+    static format_program parse(string const& fmt)
+    {
+        format_program program;
+        program.length = fmt.size();
+        if (fmt.find('%') != string::npos) {
+            program.supported = false;
+            return program;
+        }
+
+        size_t literal = 0;
+        size_t pos = 0;
+        while ((pos = fmt.find('{', pos)) != string::npos) {
+            size_t end = pos + 1;
+            int argument = 0;
+            while (end < fmt.size() && fmt[end] >= '0' && fmt[end] <= '9' && argument < 10000) {
+                argument = argument * 10 + (fmt[end] - '0');
+                ++end;
+            }
+            if (end == pos + 1 || end == fmt.size() || (fmt[end] != '}' && fmt[end] != ',')) {
+                ++pos;
+                continue;
+            }
+            end = fmt.find('}', end);
+            if (end == string::npos) {
+                break;
+            }
+            if (argument == 0) {
+                // Arguments are numbered from 1; leave anything else to boost::format to reject.
+                program.supported = false;
+                return program;
+            }
+            if (pos > literal) {
+                program.pieces.push_back({ literal, pos - literal, -1 });
+            }
+            program.pieces.push_back({ 0, 0, argument - 1 });
+            program.arguments = max(program.arguments, static_cast<size_t>(argument));
+            literal = pos = end + 1;
+        }
+        if (literal < fmt.size()) {
+            program.pieces.push_back({ literal, fmt.size() - literal, -1 });
+        }
+        return program;
+    }
+
+    // Format strings are nearly always literals, so a small cache covers them; it's emptied
+    // rather than left to grow if a caller formats dynamic text.
+    static constexpr size_t max_cached_programs = 512;
+
+    static format_program const& get_program(string const& fmt)
+    {
+        static thread_local unordered_map<string, format_program> programs;
+        auto it = programs.find(fmt);
+        if (it != programs.end()) {
+            return it->second;
+        }
+        if (programs.size() >= max_cached_programs) {
+            programs.clear();
+        }
+        return programs.emplace(fmt, parse(fmt)).first->second;
+    }
+
+    // Untranslated literals are cached by address; the same bound applies. The length is checked
+    // in case a literal from an unloaded library is replaced by another at the same address.
+    static format_program const& get_literal_program(char const* literal, string const& fmt)
+    {
+        static thread_local unordered_map<char const*, format_program> programs;
+        auto it = programs.find(literal);
+        if (it != programs.end()) {
+            if (it->second.length != fmt.size()) {
+                it->second = parse(fmt);
+            }
+            return it->second;
+        }
+        if (programs.size() >= max_cached_programs) {
+            programs.clear();
+        }
+        return programs.emplace(literal, parse(fmt)).first->second;
+    }
+
+    static bool render(format_program const& program, string const& fmt, string const& arguments, vector<size_t> const& ends, string& result)
+    {
+        if (!program.supported || program.arguments != ends.size()) {
+            return false;
+        }
+
+        size_t size = 0;
+        for (auto const& piece : program.pieces) {
+            if (piece.argument < 0) {
+                size += piece.length;
+            } else {
+                size += ends[piece.argument] - (piece.argument == 0 ? 0 : ends[piece.argument - 1]);
+            }
+        }
+
+        result.reserve(result.size() + size);
+        for (auto const& piece : program.pieces) {
+            if (piece.argument < 0) {
+                result.append(fmt, piece.offset, piece.length);
+            } else {
+                size_t begin = piece.argument == 0 ? 0 : ends[piece.argument - 1];
+                result.append(arguments, begin, ends[piece.argument] - begin);
+            }
+        }
+        return true;
+    }
+
+    bool positional_formatter::format(string const& fmt, string& result) const
+    {
+        return render(get_program(fmt), fmt, _arguments, _ends, result);
+    }
+
+    bool positional_formatter::format_literal(char const* literal, string const& fmt, string& result) const
+    {
+        if (fmt.compare(literal) != 0) {
+            // The literal was translated, so parse the translation instead.
+            return format(fmt, result);
+        }
+        return render(get_literal_program(literal, fmt), fmt, _arguments, _ends, result);
+    }
+
+}}  // namespace leatherman::locale
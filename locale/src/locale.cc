@@ -1,6 +1,11 @@
 #include <leatherman/locale/locale.hpp>
 #include <leatherman/util/environment.hpp>
-#include <map>
+#include <boost/filesystem.hpp>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
 
 // boost includes are not always warning-clean. Disable warnings that
 // cause problems before including the headers, then re-enable the warnings.
@@ -9,88 +14,393 @@
 #pragma GCC diagnostic ignored "-Wstrict-aliasing"
 #include <boost/locale.hpp>
 #pragma GCC diagnostic pop
+#include "catalog.hpp"
 
 namespace leatherman { namespace locale {
 
     using namespace std;
-    static map<string, std::locale> g_locales;
 
-    const std::locale get_locale(string const& id, string const& domain, vector<string> const& paths)
+    /**
+     * Memoizes translations for a domain, so repeated lookups of the same handful of messages skip
+     * the locale copy and catalog lookup. Split into shards by hash so threads translating different
+     * messages rarely contend for the same lock.
+     */
+    class translation_cache
+    {
+     public:
+        /**
+         * Looks up a translation.
+         * @param key The message, or a composite key built by make_key for context and plural lookups.
+         * @param translation Set to the cached translation if found.
+         * @return Returns true if the translation was cached, false otherwise.
+         */
+        bool find(string const& key, string& translation)
+        {
+            auto& s = shard_for(key);
+            lock_guard<mutex> lock(s.lock);
+            auto it = s.entries.find(key);
+            if (it == s.entries.end()) {
+                return false;
+            }
+            translation = it->second;
+            return true;
+        }
+
+        /**
+         * Caches a translation. A full shard is emptied rather than growing without bound, as happens
+         * if dynamic text is passed to translate.
+         * @param key The key the translation was looked up by.
+         * @param translation The translation.
+         */
+        void insert(string const& key, string const& translation)
+        {
+            auto& s = shard_for(key);
+            lock_guard<mutex> lock(s.lock);
+            if (s.entries.size() >= max_shard_entries) {
+                s.entries.clear();
+            }
+            s.entries.emplace(key, translation);
+        }
+
+     private:
+        static constexpr size_t shard_count = 16;
+        static constexpr size_t max_shard_entries = 256;
+
+        struct shard
+        {
+            mutex lock;
+            unordered_map<string, string> entries;
+        };
+
+        shard& shard_for(string const& key)
+        {
+            return _shards[hash<string>()(key) % shard_count];
+        }
+
+        shard _shards[shard_count];
+    };
+
+    // Plural translations are cached per n, so only for the small counts most messages are logged with.
+    static constexpr int max_cached_plural = 16;
+
+    static atomic<bool> g_mapped_catalogs{false};
+
+    static vector<string> message_paths(vector<string> const& paths)
     {
-        auto it = g_locales.find(domain);
-        if (it != g_locales.end()) {
-            return it->second;
+        // Setup so we can find installed locales. Expects a default path unless
+        // an environment variable is specified.
+        vector<string> result;
+#ifdef LEATHERMAN_LOCALE_VAR
+        string locale_path;
+        if (util::environment::get(LEATHERMAN_LOCALE_VAR, locale_path)) {
+            result.push_back(locale_path+'/'+LEATHERMAN_LOCALE_INSTALL);
         }
+#else
+        result.push_back(LEATHERMAN_LOCALE_INSTALL);
+#endif
+        result.insert(result.end(), paths.begin(), paths.end());
+        return result;
+    }
 
+    static std::locale generate_locale(string const& id, string const& domain, vector<string> const& paths, bool messages)
+    {
         // The system default locale is set with id == "", except on Windows boost::locale's
         // generator uses a compatible UTF-8 equivalent. Using boost results in UTF-8 being
         // the default on all platforms.
         boost::locale::generator gen;
 
-        if (!domain.empty()) {
-            // Setup so we can find installed locales. Expects a default path unless
-            // an environment variable is specified.
-#ifdef LEATHERMAN_LOCALE_VAR
-            string locale_path;
-            if (util::environment::get(LEATHERMAN_LOCALE_VAR, locale_path)) {
-                gen.add_messages_path(locale_path+'/'+LEATHERMAN_LOCALE_INSTALL);
-            }
-#else
-            gen.add_messages_path(LEATHERMAN_LOCALE_INSTALL);
-#endif
-            for (auto& path : paths) {
+        if (messages && !domain.empty()) {
+            for (auto& path : message_paths(paths)) {
                 gen.add_messages_path(path);
             }
             gen.add_messages_domain(domain);
         }
 
-        // Ensure creating and adding a new locale is thread-safe.
         try {
-            return g_locales.insert(make_pair(domain, gen(id))).first->second;
+            return gen(id);
         } catch(boost::locale::conv::conversion_error &e) {
-            return g_locales.insert(make_pair(domain, std::locale())).first->second;
+            return std::locale();
         }
     }
 
-    void clear_domain(string const& domain)
+    /**
+     * A domain's locale and its translation cache. The locale, and the memory mapped catalog
+     * if those are enabled, are created on first use.
+     */
+    class locale_entry
     {
-        g_locales.erase(domain);
+     public:
+        locale_entry(string domain, string id, vector<string> paths) :
+            domain(move(domain)),
+            next(nullptr),
+            _id(move(id)),
+            _paths(move(paths)),
+            _mapped(g_mapped_catalogs),
+            _generated(false),
+            _loaded(false),
+            _unsupported(false)
+        {
+        }
+
+        /**
+         * Gets the domain's locale, generating it if needed.
+         * @return Returns the locale.
+         */
+        std::locale const& locale()
+        {
+            if (!_generated.load(memory_order_acquire)) {
+                // Decide whether Boost.Locale needs to load the catalogs before taking the lock.
+                bool messages = !_mapped || (catalog(), _unsupported);
+                lock_guard<mutex> lock(_mutex);
+                if (!_generated.load(memory_order_relaxed)) {
+                    _locale = generate_locale(_id, domain, _paths, messages);
+                    _generated.store(true, memory_order_release);
+                }
+            }
+            return _locale;
+        }
+
+        /**
+         * Determines if translations are looked up in a memory mapped catalog.
+         * @return Returns true if the catalog is mapped, or if there's no catalog for the language.
+         */
+        bool mapped()
+        {
+            return _mapped && (catalog(), !_unsupported);
+        }
+
+        /**
+         * Gets the domain's memory mapped catalog, mapping it if needed.
+         * @return Returns the catalog, or nullptr if there's no catalog for the language.
+         */
+        message_catalog const* catalog()
+        {
+            if (!_loaded.load(memory_order_acquire)) {
+                lock_guard<mutex> lock(_mutex);
+                if (!_loaded.load(memory_order_relaxed)) {
+                    load_catalog();
+                    _loaded.store(true, memory_order_release);
+                }
+            }
+            return _catalog.get();
+        }
+
+        string const domain;
+        translation_cache cache;
+        atomic<locale_entry*> next;
+
+     private:
+        void load_catalog()
+        {
+            if (domain.empty()) {
+                return;
+            }
+            string language, country;
+            parse_locale_name(_id.empty() ? boost::locale::util::get_system_locale() : _id, language, country);
+            // Messages are written in English, so there's nothing to load for it.
+            if (language.empty() || language == "C" || language == "POSIX" || language == "en") {
+                return;
+            }
+
+            vector<string> names;
+            if (!country.empty()) {
+                names.push_back(language + "_" + country);
+            }
+            names.push_back(language);
+            for (auto const& name : names) {
+                for (auto const& path : message_paths(_paths)) {
+                    auto file = path + "/" + name + "/LC_MESSAGES/" + domain + ".mo";
+                    boost::system::error_code ec;
+                    if (!boost::filesystem::exists(file, ec)) {
+                        continue;
+                    }
+                    _catalog = message_catalog::open(file);
+                    // Leave catalogs that can't be mapped, such as those that aren't UTF-8, to Boost.Locale.
+                    _unsupported = !_catalog;
+                    return;
+                }
+            }
+        }
+
+        string const _id;
+        vector<string> const _paths;
+        bool const _mapped;
+        mutex _mutex;
+        atomic<bool> _generated;
+        atomic<bool> _loaded;
+        bool _unsupported;
+        std::locale _locale;
+        unique_ptr<message_catalog> _catalog;
+    };
+
+    // The registry is a list that's read without locking. Entries are only added, fully constructed,
+    // under g_registry_mutex, and clear_domain unlinks them without freeing them, so a reader can
+    // never see a partial or freed entry and references to an entry's locale stay valid.
+    static atomic<locale_entry*> g_locales{nullptr};
+    static mutex g_registry_mutex;
+    static vector<unique_ptr<locale_entry>> g_entries;
+
+    static locale_entry* find_entry(string const& domain)
+    {
+        for (auto entry = g_locales.load(memory_order_acquire); entry; entry = entry->next.load(memory_order_acquire)) {
+            if (entry->domain == domain) {
+                return entry;
+            }
+        }
+        return nullptr;
     }
 
-    string translate(string const& msg, string const& domain)
+    static locale_entry& get_entry(string const& id, string const& domain, vector<string> const& paths = {PROJECT_DIR})
     {
-        try {
-            return boost::locale::translate(msg).str(get_locale("", domain));
-        } catch (exception const&) {
-            return msg;
+        auto entry = find_entry(domain);
+        if (entry) {
+            return *entry;
+        }
+
+        // Entries are cheap to create; each generates its locale on first use, so threads that
+        // need the same domain wait for it rather than generating their own.
+        lock_guard<mutex> lock(g_registry_mutex);
+        entry = find_entry(domain);
+        if (entry) {
+            return *entry;
         }
+        g_entries.emplace_back(new locale_entry(domain, id, paths));
+        entry = g_entries.back().get();
+        entry->next.store(g_locales.load(memory_order_relaxed), memory_order_relaxed);
+        g_locales.store(entry, memory_order_release);
+        return *entry;
     }
 
-    string translate_p(string const& context, string const& msg, string const& domain)
+    /**
+     * Looks up a translation in the domain's cache, translating and caching it if it's missing.
+     * @param domain The catalog domain.
+     * @param key The cache key, or nullptr to skip the cache.
+     * @param translate Translates the message with the domain's locale or catalog.
+     * @param fallback The result if translation fails.
+     * @return Returns the translated string.
+     */
+    template <typename Translate>
+    static string lookup(string const& domain, string const* key, Translate translate, string const& fallback)
     {
         try {
-            return boost::locale::translate(context, msg).str(get_locale("", domain));
+            auto& entry = get_entry("", domain);
+            string translation;
+            if (key && entry.cache.find(*key, translation)) {
+                return translation;
+            }
+            translation = translate(entry);
+            if (key) {
+                entry.cache.insert(*key, translation);
+            }
+            return translation;
         } catch (exception const&) {
-            return msg;
+            return fallback;
+        }
+    }
+
+    // Builds a key for lookups other than a plain translate. The separators can't appear in
+    // messages: \4 separates a context from its message, as in gettext catalogs, and \0 the plural.
+    static string make_key(string const* context, string const& msg, string const* plural = nullptr, int n = 0)
+    {
+        string key;
+        if (context) {
+            key += *context;
+            key += '\4';
+        }
+        key += msg;
+        if (plural) {
+            key += '\0';
+            key += *plural;
+            key += '\0';
+            key += to_string(n);
+        }
+        return key;
+    }
+
+    const std::locale get_locale(string const& id, string const& domain, vector<string> const& paths)
+    {
+        return get_entry(id, domain, paths).locale();
+    }
+
+    std::locale const& get_locale_ref(string const& id, string const& domain, vector<string> const& paths)
+    {
+        return get_entry(id, domain, paths).locale();
+    }
+
+    void clear_domain(string const& domain)
+    {
+        lock_guard<mutex> lock(g_registry_mutex);
+        auto link = &g_locales;
+        for (auto entry = link->load(); entry; link = &entry->next, entry = link->load()) {
+            if (entry->domain == domain) {
+                link->store(entry->next.load(), memory_order_release);
+                break;
+            }
         }
     }
 
+    string translate(string const& msg, string const& domain)
+    {
+        return lookup(domain, &msg, [&](locale_entry& entry) -> string {
+            string translation;
+            if (!entry.mapped()) {
+                return boost::locale::translate(msg).str(entry.locale());
+            }
+            auto catalog = entry.catalog();
+            return catalog && catalog->find(nullptr, msg, nullptr, 0, translation) ? translation : msg;
+        }, msg);
+    }
+
+    string translate_p(string const& context, string const& msg, string const& domain)
+    {
+        auto key = make_key(&context, msg);
+        return lookup(domain, &key, [&](locale_entry& entry) -> string {
+            string translation;
+            if (!entry.mapped()) {
+                return boost::locale::translate(context, msg).str(entry.locale());
+            }
+            auto catalog = entry.catalog();
+            return catalog && catalog->find(&context, msg, nullptr, 0, translation) ? translation : msg;
+        }, msg);
+    }
+
     string translate_n(string const& single, string const& plural, int n, string const& domain)
     {
-        try {
-            return boost::locale::translate(single, plural, n).str(get_locale("", domain));
-        } catch (exception const&) {
-            return n == 1 ? single : plural;
+        string key;
+        bool cacheable = n >= 0 && n < max_cached_plural;
+        if (cacheable) {
+            key = make_key(nullptr, single, &plural, n);
         }
+        return lookup(domain, cacheable ? &key : nullptr, [&](locale_entry& entry) -> string {
+            string translation;
+            if (!entry.mapped()) {
+                return boost::locale::translate(single, plural, n).str(entry.locale());
+            }
+            auto catalog = entry.catalog();
+            return catalog && catalog->find(nullptr, single, &plural, n, translation) ? translation : (n == 1 ? single : plural);
+        }, n == 1 ? single : plural);
     }
 
     string translate_np(string const& context, string const& single, string const& plural, int n, string const& domain)
     {
-        try {
-            return boost::locale::translate(context, single, plural, n).str(get_locale("", domain));
-        } catch (exception const&) {
-            return n == 1 ? single : plural;
+        string key;
+        bool cacheable = n >= 0 && n < max_cached_plural;
+        if (cacheable) {
+            key = make_key(&context, single, &plural, n);
         }
+        return lookup(domain, cacheable ? &key : nullptr, [&](locale_entry& entry) -> string {
+            string translation;
+            if (!entry.mapped()) {
+                return boost::locale::translate(context, single, plural, n).str(entry.locale());
+            }
+            auto catalog = entry.catalog();
+            return catalog && catalog->find(&context, single, &plural, n, translation) ? translation : (n == 1 ? single : plural);
+        }, n == 1 ? single : plural);
+    }
+
+    void use_mapped_catalogs(bool enabled)
+    {
+        g_mapped_catalogs = enabled;
     }
 
 }}  // namespace leatherman::locale
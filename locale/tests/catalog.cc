@@ -0,0 +1,161 @@
+#include <catch.hpp>
+#include <leatherman/locale/locale.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/nowide/fstream.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+
+using namespace std;
+using namespace leatherman::locale;
+namespace fs = boost::filesystem;
+
+namespace leatherman { namespace test {
+
+    /**
+     * Writes a message catalog in the .mo format msgfmt produces, optionally with a hash table.
+     */
+    static void write_catalog(fs::path const& file, vector<pair<string, string>> messages, bool hashed)
+    {
+        sort(messages.begin(), messages.end(), [](pair<string, string> const& a, pair<string, string> const& b) {
+            return strcmp(a.first.c_str(), b.first.c_str()) < 0;
+        });
+        uint32_t count = static_cast<uint32_t>(messages.size());
+        uint32_t hash_size = hashed ? 7 : 0;
+        vector<uint32_t> hash_table(hash_size);
+        if (hashed) {
+            for (uint32_t i = 0; i < count; ++i) {
+                uint64_t hval = 0;
+                for (unsigned char c : messages[i].first.substr(0, messages[i].first.find('\0'))) {
+                    hval = (hval << 4) + c;
+                    uint64_t g = hval & (~static_cast<uint64_t>(0) << 28);
+                    if (g != 0) {
+                        hval ^= g >> 24;
+                        hval ^= g;
+                    }
+                }
+                uint32_t index = hval % hash_size;
+                uint32_t increment = 1 + hval % (hash_size - 2);
+                while (hash_table[index] != 0) {
+                    index = index >= hash_size - increment ? index - (hash_size - increment) : index + increment;
+                }
+                hash_table[index] = i + 1;
+            }
+        }
+
+        vector<uint32_t> words = { 0x950412de, 0, count, 28, 28 + count * 8, hash_size, 28 + count * 16 };
+        uint32_t offset = 28 + count * 16 + hash_size * 4;
+        string strings;
+        vector<uint32_t> originals, translations;
+        for (auto const& message : messages) {
+            originals.push_back(static_cast<uint32_t>(message.first.size()));
+            originals.push_back(offset + static_cast<uint32_t>(strings.size()));
+            strings += message.first;
+            strings += '\0';
+        }
+        for (auto const& message : messages) {
+            translations.push_back(static_cast<uint32_t>(message.second.size()));
+            translations.push_back(offset + static_cast<uint32_t>(strings.size()));
+            strings += message.second;
+            strings += '\0';
+        }
+        words.insert(words.end(), originals.begin(), originals.end());
+        words.insert(words.end(), translations.begin(), translations.end());
+        words.insert(words.end(), hash_table.begin(), hash_table.end());
+
+        fs::create_directories(file.parent_path());
+        boost::nowide::ofstream out(file.string().c_str(), ios::binary);
+        out.write(reinterpret_cast<char const*>(words.data()), words.size() * sizeof(uint32_t));
+        out.write(strings.data(), strings.size());
+    }
+
+    struct mapped_catalog_context
+    {
+        explicit mapped_catalog_context(bool hashed) :
+            dir(fs::temp_directory_path() / fs::unique_path("lth_catalog_%%%%-%%%%"))
+        {
+            vector<pair<string, string>> messages = {
+                { "", "Content-Type: text/plain; charset=UTF-8\n"
+                      "Plural-Forms: nplurals=3; plural=(n==1 ? 0 : n%10>=2 && n%10<=4 && (n%100<10 || n%100>=20) ? 1 : 2);\n" },
+                { "hello", "bonjour" },
+                { string("greeting\4hello"), "salut" },
+                { string("{1} file\0{1} files", 18), string("{1} plik\0{1} pliki\0{1} plik\xc3\xb3w", 30) },
+            };
+            write_catalog(dir / "pl" / "LC_MESSAGES" / (domain + ".mo"), messages, hashed);
+            write_catalog(dir / "en" / "LC_MESSAGES" / (domain + ".mo"), messages, hashed);
+            use_mapped_catalogs();
+        }
+
+        ~mapped_catalog_context()
+        {
+            use_mapped_catalogs(false);
+            clear_domain(domain);
+            fs::remove_all(dir);
+        }
+
+        fs::path dir;
+        string const domain = "lth_catalog_test";
+    };
+
+}}  // namespace leatherman::test
+
+using namespace leatherman::test;
+
+static void require_translations(string const& domain)
+{
+    REQUIRE(translate("hello", domain) == "bonjour");
+    REQUIRE(translate_p("greeting", "hello", domain) == "salut");
+
+    // The catalog's plural forms are used.
+    REQUIRE(translate_n("{1} file", "{1} files", 1, domain) == "{1} plik");
+    REQUIRE(translate_n("{1} file", "{1} files", 3, domain) == "{1} pliki");
+    REQUIRE(translate_n("{1} file", "{1} files", 5, domain) == "{1} plik\xc3\xb3w");
+    REQUIRE(translate_n("{1} file", "{1} files", 22, domain) == "{1} pliki");
+    REQUIRE(translate_n("{1} file", "{1} files", 112, domain) == "{1} plik\xc3\xb3w");
+
+    // Messages that aren't in the catalog are returned as they are.
+    REQUIRE(translate("goodbye", domain) == "goodbye");
+    REQUIRE(translate_p("farewell", "hello", domain) == "hello");
+    REQUIRE(translate_n("{1} dir", "{1} dirs", 2, domain) == "{1} dirs");
+}
+
+SCENARIO("translating with a memory mapped catalog", "[locale]") {
+    GIVEN("a catalog with a hash table") {
+        mapped_catalog_context context(true);
+        get_locale_ref("pl_PL.UTF-8", context.domain, { context.dir.string() });
+
+        THEN("messages are translated") {
+            require_translations(context.domain);
+        }
+    }
+
+    GIVEN("a catalog without a hash table") {
+        mapped_catalog_context context(false);
+        get_locale_ref("pl_PL.UTF-8", context.domain, { context.dir.string() });
+
+        THEN("messages are translated") {
+            require_translations(context.domain);
+        }
+    }
+
+    GIVEN("English") {
+        mapped_catalog_context context(true);
+        get_locale_ref("en_US.UTF-8", context.domain, { context.dir.string() });
+
+        THEN("messages are not translated") {
+            REQUIRE(translate("hello", context.domain) == "hello");
+            REQUIRE(translate_n("{1} file", "{1} files", 2, context.domain) == "{1} files");
+        }
+    }
+
+    GIVEN("a language without a catalog") {
+        mapped_catalog_context context(true);
+        get_locale_ref("de_DE.UTF-8", context.domain, { context.dir.string() });
+
+        THEN("messages are not translated") {
+            REQUIRE(translate("hello", context.domain) == "hello");
+            REQUIRE(translate_n("{1} file", "{1} files", 1, context.domain) == "{1} file");
+        }
+    }
+}
@@ -8,6 +8,8 @@
 using namespace std;
 using namespace leatherman::locale;
 
+static constexpr char literal_array[] = "requesting {1} item.";
+
 SCENARIO("a format string", "[locale]") {
     auto literal = "requesting {1} item.";
 
@@ -114,4 +116,95 @@ SCENARIO("a format string", "[locale]") {
             REQUIRE(np_("foo", literal, plural, 2, 3.7) == "requesting 3.7 items.");
         }
     }
+
+    GIVEN("format strings with several arguments") {
+        THEN("arguments are substituted by position") {
+            REQUIRE(format("{2} then {1}, {2} again", "first", string("second")) == "second then first, second again");
+        }
+
+        THEN("arguments of different types are rendered as with a stream") {
+            REQUIRE(format("{1} {2} {3} {4} {5}", 1, 2.5, 'c', true, 1e20) == "1 2.5 c 1 1e+20");
+        }
+
+        THEN("formatting options are ignored") {
+            REQUIRE(format("requesting {1,number}.", 3) == "requesting 3.");
+        }
+
+        THEN("braces that aren't placeholders are copied") {
+            REQUIRE(format("{} {a} {1} {", 1) == "{} {a} 1 {");
+        }
+
+        THEN("a format string can be used repeatedly") {
+            for (int i = 0; i < 3; ++i) {
+                REQUIRE(format("message {1}", i) == "message " + to_string(i));
+            }
+        }
+
+        THEN("format arguments can themselves be formatted") {
+            REQUIRE(format("outer {1} {2}", format("inner {1}", 1), 2) == "outer inner 1 2");
+        }
+    }
+
+    GIVEN("Boost.Format style format strings") {
+        THEN("directives are still supported") {
+            REQUIRE(format("%1% (%2$#x)", "code", 255) == "code (0xff)");
+            REQUIRE(format("{1} is 100%%", "it") == "it is 100%");
+        }
+
+        THEN("mismatched arguments are reported") {
+            REQUIRE_THROWS_AS(format("{1} {2}", 1), boost::io::format_error);
+            REQUIRE_THROWS_AS(format("{1}", 1, 2), boost::io::format_error);
+        }
+    }
+
+    GIVEN("leatherman::locale::format_to") {
+        string buffer = "prefix: ";
+
+        THEN("the formatted message is appended to the buffer") {
+            format_to(buffer, literal, 1.25);
+            REQUIRE(buffer == "prefix: requesting 1.25 item.");
+        }
+
+        THEN("messages with context are appended to the buffer") {
+            format_p_to(buffer, "foo", literal, 1.25);
+            REQUIRE(buffer == "prefix: requesting 1.25 item.");
+        }
+
+        THEN("plural messages are appended to the buffer") {
+            format_n_to(buffer, literal, "requesting {1} items.", 2, 3.7);
+            format_np_to(buffer, "foo", literal, "requesting {1} items.", 1, 3.7);
+            REQUIRE(buffer == "prefix: requesting 3.7 items.requesting 3.7 item.");
+        }
+
+        THEN("Boost.Format style format strings are appended to the buffer") {
+            format_to(buffer, "%1%%%", 50);
+            REQUIRE(buffer == "prefix: 50%");
+        }
+    }
+
+    GIVEN("LEATHERMAN_FORMAT") {
+        THEN("placeholders are counted at compile time") {
+            static_assert(highest_placeholder("no placeholders") == 0, "");
+            static_assert(highest_placeholder("{2} and {1}") == 2, "");
+            static_assert(highest_placeholder("{1,number} {12}") == 12, "");
+            static_assert(highest_placeholder("{} {a} {1") == 0, "");
+            static_assert(highest_placeholder("%1% {1}") == -1, "");
+        }
+
+        THEN("messages should perform substitution") {
+            REQUIRE(LEATHERMAN_FORMAT(literal_array, 1.25) == "requesting 1.25 item.");
+            REQUIRE(LEATHERMAN_FORMAT("{2} then {1}", "first", 2) == "2 then first");
+            REQUIRE(LEATHERMAN_FORMAT("no placeholders") == "no placeholders");
+        }
+
+        THEN("a format string can be used repeatedly") {
+            for (int i = 0; i < 3; ++i) {
+                REQUIRE(LEATHERMAN_FORMAT("message {1}", i) == "message " + to_string(i));
+            }
+        }
+
+        THEN("Boost.Format style format strings are not checked") {
+            REQUIRE(LEATHERMAN_FORMAT("%1%%%", 50) == "50%");
+        }
+    }
 }
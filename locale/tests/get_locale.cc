@@ -0,0 +1,61 @@
+#include <catch.hpp>
+#include <leatherman/locale/locale.hpp>
+#include <atomic>
+#include <thread>
+
+using namespace std;
+using namespace leatherman::locale;
+
+SCENARIO("getting a locale for a domain", "[locale]") {
+    // A domain without catalogs, so nothing is translated.
+    static const string domain = "lth_get_locale_test";
+
+    GIVEN("a locale that has been created") {
+        auto const& loc = get_locale_ref("", domain);
+
+        THEN("the same locale is returned for the domain") {
+            REQUIRE(&get_locale_ref("", domain) == &loc);
+            REQUIRE(get_locale("", domain) == loc);
+        }
+
+        THEN("clearing the domain creates a new locale but keeps the old one valid") {
+            clear_domain(domain);
+            auto const& recreated = get_locale_ref("", domain);
+            REQUIRE(&recreated != &loc);
+            REQUIRE(loc.name() == recreated.name());
+        }
+    }
+
+    GIVEN("several threads using a new domain at once") {
+        clear_domain(domain);
+        atomic<bool> start{false};
+        vector<locale const*> seen(8);
+        vector<string> translated(seen.size());
+        vector<thread> threads;
+        for (size_t i = 0; i < seen.size(); ++i) {
+            threads.emplace_back([&, i]() {
+                while (!start) {
+                    this_thread::yield();
+                }
+                translated[i] = translate("requesting {1} item.", domain);
+                seen[i] = &get_locale_ref("", domain);
+            });
+        }
+        start = true;
+        for (auto& t : threads) {
+            t.join();
+        }
+
+        THEN("they all get the same locale") {
+            for (auto loc : seen) {
+                REQUIRE(loc == seen.front());
+                REQUIRE(loc == &get_locale_ref("", domain));
+            }
+            for (auto const& message : translated) {
+                REQUIRE(message == "requesting {1} item.");
+            }
+        }
+    }
+
+    clear_domain(domain);
+}
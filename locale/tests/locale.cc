@@ -188,3 +188,31 @@ SCENARIO("a french locale", "[locale]") {
 
     clear_domain();
 }
+
+SCENARIO("translations are cached until the domain is cleared", "[locale]") {
+    auto loc = get_locale("fr.UTF-8");
+
+    GIVEN("a message translated repeatedly") {
+        for (int i = 0; i < 3; ++i) {
+            REQUIRE(translate("requesting {1,number}.") == "demande {1,number}.");
+            REQUIRE(translate_p("foo", "requesting {1,number}.") == "demandé {1,number}.");
+        }
+
+        THEN("each plural form is cached separately") {
+            REQUIRE(translate_n("requesting {1,number} item.", "requesting {1,number} items.", 1) == "demande {1,number} objet.");
+            REQUIRE(translate_n("requesting {1,number} item.", "requesting {1,number} items.", 2) == "demande {1,number} objets.");
+            REQUIRE(translate_n("requesting {1,number} item.", "requesting {1,number} items.", 1) == "demande {1,number} objet.");
+            REQUIRE(translate_np("foo", "requesting {1,number} item.", "requesting {1,number} items.", 2) == "demandé {1,number} objets.");
+            REQUIRE(translate_n("requesting {1,number} item.", "requesting {1,number} items.", 100) == "demande {1,number} objets.");
+        }
+
+        THEN("clearing the domain discards the cached translations") {
+            clear_domain();
+            loc = get_locale("C");
+            REQUIRE(translate("requesting {1,number}.") == "requesting {1,number}.");
+            REQUIRE(translate_p("foo", "requesting {1,number}.") == "requesting {1,number}.");
+        }
+    }
+
+    clear_domain();
+}
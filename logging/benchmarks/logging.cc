@@ -0,0 +1,231 @@
+/**
+ * @file
+ * Measures the cost of logging across backends and thread counts, and writes the results as JSON.
+ * Usage: lth_logging_benchmark [iterations per thread] [maximum threads]
+ */
+#include <leatherman/logging/logging.hpp>
+#include <boost/nowide/iostream.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#ifndef _WIN32
+#include <boost/filesystem.hpp>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <cstring>
+#endif
+
+using namespace std;
+using namespace leatherman::logging;
+
+namespace {
+
+    /**
+     * Discards everything written to it, so stream sinks measure formatting rather than I/O.
+     */
+    class null_buffer : public streambuf
+    {
+     protected:
+        int_type overflow(int_type c) override
+        {
+            return traits_type::not_eof(c);
+        }
+
+        streamsize xsputn(char_type const*, streamsize count) override
+        {
+            return count;
+        }
+    };
+
+    struct result
+    {
+        string name;
+        unsigned int threads;
+        uint64_t operations;
+        double seconds;
+    };
+
+    /**
+     * Runs body(iterations) on each of the given number of threads at once and times the whole run.
+     */
+    template <typename Body>
+    result measure(string name, unsigned int threads, uint64_t iterations, Body body)
+    {
+        atomic<unsigned int> ready{0};
+        atomic<bool> go{false};
+        vector<thread> workers;
+        for (unsigned int i = 0; i < threads; ++i) {
+            workers.emplace_back([&]() {
+                ++ready;
+                while (!go) {
+                    this_thread::yield();
+                }
+                body(iterations);
+            });
+        }
+        while (ready != threads) {
+            this_thread::yield();
+        }
+        auto start = chrono::steady_clock::now();
+        go = true;
+        for (auto& worker : workers) {
+            worker.join();
+        }
+        chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+        return result{ move(name), threads, iterations * threads, elapsed.count() };
+    }
+
+    void log_debug(uint64_t iterations)
+    {
+        for (uint64_t i = 0; i < iterations; ++i) {
+            LOG_DEBUG("benchmark message {1} of {2}", i, iterations);
+        }
+    }
+
+    void log_warning(uint64_t iterations)
+    {
+        for (uint64_t i = 0; i < iterations; ++i) {
+            LOG_WARNING("benchmark message {1} of {2}", i, iterations);
+        }
+    }
+
+    void write_json(ostream& out, vector<result> const& results)
+    {
+        out << "{\n  \"benchmark\": \"leatherman_logging\",\n";
+        out << "  \"hardware_threads\": " << thread::hardware_concurrency() << ",\n";
+        out << "  \"results\": [";
+        bool first = true;
+        for (auto const& r : results) {
+            out << (first ? "\n" : ",\n");
+            first = false;
+            out << "    { \"name\": \"" << r.name << "\", \"threads\": " << r.threads
+                << ", \"operations\": " << r.operations
+                << fixed << setprecision(3)
+                << ", \"seconds\": " << r.seconds
+                << ", \"ns_per_op\": " << (r.seconds * 1e9 / r.operations)
+                << setprecision(0)
+                << ", \"ops_per_sec\": " << (r.operations / r.seconds) << " }";
+            out.unsetf(ios_base::floatfield);
+        }
+        out << "\n  ]\n}\n";
+    }
+
+}  // namespace
+
+int main(int argc, char** argv)
+{
+    uint64_t iterations = argc > 1 ? strtoull(argv[1], nullptr, 10) : 100000;
+    unsigned int max_threads = argc > 2 ? static_cast<unsigned int>(strtoul(argv[2], nullptr, 10))
+                                        : max(1u, min(8u, thread::hardware_concurrency()));
+    iterations = max<uint64_t>(iterations, 1);
+    max_threads = max(max_threads, 1u);
+
+    vector<unsigned int> thread_counts;
+    for (unsigned int threads = 1; threads < max_threads; threads *= 2) {
+        thread_counts.push_back(threads);
+    }
+    thread_counts.push_back(max_threads);
+
+    null_buffer discard;
+    ostream null_stream(&discard);
+    vector<result> results;
+
+    // A message below the current level: the cost every disabled LOG_* call pays.
+    setup_logging(null_stream);
+    set_level(log_level::warning);
+    results.push_back(measure("disabled_level", 1, iterations * 10, log_debug));
+
+    // Formatting and writing through Boost.Log to a stream.
+    for (auto threads : thread_counts) {
+        results.push_back(measure("stream", threads, iterations, log_warning));
+    }
+
+    // Formatting and writing one JSON object per message.
+    setup_json_logging(null_stream);
+    for (auto threads : thread_counts) {
+        results.push_back(measure("json", threads, iterations, log_warning));
+    }
+
+    // An on_message callback that swallows every message, as a UI forwarder or counter would.
+    setup_logging(null_stream);
+    set_level(log_level::trace);
+    atomic<uint64_t> seen{0};
+    on_message([&](log_level, string const&) {
+        ++seen;
+        return false;
+    });
+    for (auto threads : thread_counts) {
+        results.push_back(measure("on_message", threads, iterations, log_warning));
+    }
+
+    // The cost of looking up a message for translation in log(), against the raw path that skips it.
+    results.push_back(measure("log_translated", 1, iterations, [](uint64_t count) {
+        for (uint64_t i = 0; i < count; ++i) {
+            log(LOG_NAMESPACE, log_level::debug, 0, "a line of child process output");
+        }
+    }));
+    results.push_back(measure("log_raw", 1, iterations, [](uint64_t count) {
+        for (uint64_t i = 0; i < count; ++i) {
+            log_raw(LOG_NAMESPACE, log_level::debug, 0, "a line of child process output");
+        }
+    }));
+    on_message(nullptr);
+
+#ifndef _WIN32
+    // The file backend, writing to /dev/null so only the library's own buffering is measured.
+    setup_file_logging("/dev/null");
+    for (auto threads : thread_counts) {
+        results.push_back(measure("file", threads, iterations, log_warning));
+    }
+    clean_file_logging();
+
+    // The native syslog client, sending to a local socket drained by a stand-in daemon.
+    auto path = (boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("lth_bench_%%%%-%%%%")).string();
+    int daemon = socket(AF_UNIX, SOCK_DGRAM, 0);
+    sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+    if (daemon >= 0 && bind(daemon, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0) {
+        atomic<bool> stopping{false};
+        thread drain([&]() {
+            char buffer[4096];
+            timeval timeout = { 0, 100000 };
+            setsockopt(daemon, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+            while (!stopping) {
+                recv(daemon, buffer, sizeof(buffer), 0);
+            }
+        });
+
+        syslog_options options;
+        options.socket_path = path;
+        setup_native_syslog_logging("lth_logging_benchmark", "user", options);
+        set_level(log_level::trace);
+        for (auto threads : thread_counts) {
+            results.push_back(measure("syslog", threads, iterations, log_warning));
+            flush_syslog_logging();
+        }
+        clean_syslog_logging();
+        disable_syslog();
+
+        stopping = true;
+        drain.join();
+    }
+    if (daemon >= 0) {
+        close(daemon);
+        unlink(path.c_str());
+    }
+#endif
+
+    set_level(log_level::none);
+    write_json(boost::nowide::cout, results);
+    return 0;
+}
@@ -14,8 +14,14 @@
 #include <leatherman/locale/locale.hpp>
 #include <boost/log/core.hpp>
 #include <boost/log/expressions.hpp>
+#include <boost/utility/string_ref.hpp>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
 #include <cstdio>
 #include <functional>
+#include <utility>
+#include <vector>
 
 /**
  * Defines the logging namespace.
@@ -29,6 +35,7 @@
 
 /**
  * Logs a message.
+ * Each use has its own call_site, so messages from it can be rate limited and de-duplicated.
  * @param level The logging level for the message.
  * @param line_num The source line number of the logging call.
  * @param format The format message.
@@ -36,13 +43,15 @@
  */
 #ifdef LEATHERMAN_LOGGING_LINE_NUMBERS
 #define LOG_MESSAGE(level, line_num, format, ...) \
-    if (leatherman::logging::is_enabled(level)) { \
-        leatherman::logging::log(LOG_NAMESPACE, level, line_num, format, ##__VA_ARGS__); \
+    if (leatherman::logging::is_enabled(level) || leatherman::logging::is_recording(level)) { \
+        static leatherman::logging::call_site lth_call_site; \
+        leatherman::logging::log(lth_call_site, LOG_NAMESPACE, level, line_num, format, ##__VA_ARGS__); \
     }
 #else
 #define LOG_MESSAGE(level, line_num, format, ...) \
-    if (leatherman::logging::is_enabled(level)) { \
-        leatherman::logging::log(LOG_NAMESPACE, level, 0, format, ##__VA_ARGS__); \
+    if (leatherman::logging::is_enabled(level) || leatherman::logging::is_recording(level)) { \
+        static leatherman::logging::call_site lth_call_site; \
+        leatherman::logging::log(lth_call_site, LOG_NAMESPACE, level, 0, format, ##__VA_ARGS__); \
     }
 #endif
 /**
@@ -81,6 +90,55 @@
  * @param ... The format message parameters.
  */
 #define LOG_FATAL(format, ...) LOG_MESSAGE(leatherman::logging::log_level::fatal, __LINE__, format, ##__VA_ARGS__)
+/**
+ * Logs a message as-is, without translation or formatting, for messages that carry data such as program output.
+ * @param level The logging level for the message.
+ * @param line_num The source line number of the logging call.
+ * @param message The message.
+ */
+#ifdef LEATHERMAN_LOGGING_LINE_NUMBERS
+#define LOG_RAW_MESSAGE(level, line_num, message) \
+    if (leatherman::logging::is_enabled(level) || leatherman::logging::is_recording(level)) { \
+        static leatherman::logging::call_site lth_call_site; \
+        leatherman::logging::log_raw(lth_call_site, LOG_NAMESPACE, level, line_num, message); \
+    }
+#else
+#define LOG_RAW_MESSAGE(level, line_num, message) \
+    if (leatherman::logging::is_enabled(level) || leatherman::logging::is_recording(level)) { \
+        static leatherman::logging::call_site lth_call_site; \
+        leatherman::logging::log_raw(lth_call_site, LOG_NAMESPACE, level, 0, message); \
+    }
+#endif
+/**
+ * Logs a trace message without translation or formatting.
+ * @param message The message.
+ */
+#define LOG_RAW_TRACE(message) LOG_RAW_MESSAGE(leatherman::logging::log_level::trace, __LINE__, message)
+/**
+ * Logs a debug message without translation or formatting.
+ * @param message The message.
+ */
+#define LOG_RAW_DEBUG(message) LOG_RAW_MESSAGE(leatherman::logging::log_level::debug, __LINE__, message)
+/**
+ * Logs an info message without translation or formatting.
+ * @param message The message.
+ */
+#define LOG_RAW_INFO(message) LOG_RAW_MESSAGE(leatherman::logging::log_level::info, __LINE__, message)
+/**
+ * Logs a warning message without translation or formatting.
+ * @param message The message.
+ */
+#define LOG_RAW_WARNING(message) LOG_RAW_MESSAGE(leatherman::logging::log_level::warning, __LINE__, message)
+/**
+ * Logs an error message without translation or formatting.
+ * @param message The message.
+ */
+#define LOG_RAW_ERROR(message) LOG_RAW_MESSAGE(leatherman::logging::log_level::error, __LINE__, message)
+/**
+ * Logs a fatal message without translation or formatting.
+ * @param message The message.
+ */
+#define LOG_RAW_FATAL(message) LOG_RAW_MESSAGE(leatherman::logging::log_level::fatal, __LINE__, message)
 /**
  * Determines if the trace logging level is enabled.
  * @returns Returns true if trace logging is enabled or false if it is not enabled.
@@ -130,8 +188,16 @@ namespace leatherman { namespace logging {
 
     /**
      * Represents the supported logging backends.
+     * The stream backend writes through Boost.Log to the stream given to setup_logging;
+     * the file backend writes directly to a file owned by the logging library;
+     * the json backend writes one JSON object per message to the stream given to setup_json_logging.
      */
-    enum class logging_backend { eventlog, syslog, file };
+    enum class logging_backend { eventlog, syslog, file, stream, json };
+
+    /**
+     * Additional string fields to include in every JSON log record, as name/value pairs.
+     */
+    using json_log_fields = std::vector<std::pair<std::string, std::string>>;
 
     /**
      * Represents the supported syslog facilities
@@ -185,6 +251,16 @@ namespace leatherman { namespace logging {
      */
     void setup_logging(std::ostream &dst, std::string locale = "", std::string domain = PROJECT_NAME, bool use_locale = true);
 
+    /**
+     * Sets up logging of one JSON object per line to the given stream.
+     * Each object has timestamp, level, namespace, line (if known), thread and message fields,
+     * followed by any additional fields given here. Messages are not colorized.
+     * The logging level is set to warning by default.
+     * @param dst Destination stream for logging output.
+     * @param fields Additional fields to include in every record.
+     */
+    void setup_json_logging(std::ostream &dst, json_log_fields fields = json_log_fields());
+
     /**
      * Registers application to event log and configures event log handle
      * The logging level is set to warning by default.
@@ -200,6 +276,184 @@ namespace leatherman { namespace logging {
      */
     void setup_syslog_logging(const char* application, const std::string& facility);
 
+    /**
+     * Options for the file logging backend.
+     */
+    struct file_logging_options
+    {
+        /**
+         * Size of the user-space buffer messages are collected in; the buffer is written when full.
+         */
+        size_t buffer_size = 64 * 1024;
+
+        /**
+         * Longest time a buffered message waits before being written. Zero writes every message immediately.
+         */
+        std::chrono::milliseconds flush_interval = std::chrono::milliseconds(1000);
+
+        /**
+         * Messages at or above this level are written immediately, along with anything buffered before them.
+         */
+        log_level flush_level = log_level::warning;
+
+        /**
+         * Rotate the log file once it grows to this many bytes. Zero disables size-based rotation.
+         */
+        uint64_t rotate_size = 0;
+
+        /**
+         * Rotate the log file once it has been open for this long. Zero disables time-based rotation.
+         */
+        std::chrono::seconds rotate_interval = std::chrono::seconds(0);
+
+        /**
+         * Number of rotated files to keep, named <path>.1 (newest) through <path>.N.
+         * Zero truncates the log file on rotation instead.
+         */
+        unsigned int rotate_count = 5;
+
+        /**
+         * Called on a background thread with the path of each newly rotated file, e.g. to compress it.
+         */
+        std::function<void(std::string const&)> on_rotate;
+
+        /**
+         * Reopen the log file when the process receives SIGHUP, for use with external log rotation.
+         */
+        bool reopen_on_sighup = false;
+
+        /**
+         * Write one JSON object per message, as the json backend does, instead of plain text.
+         */
+        bool json = false;
+
+        /**
+         * Additional fields to include in every record when writing JSON.
+         */
+        json_log_fields json_fields;
+    };
+
+    /**
+     * Configures application to log to a file.
+     * The file is opened for appending and created if it does not exist.
+     * The logging level is set to warning by default.
+     * Throws a runtime_error if the file cannot be opened.
+     * @param path The path of the log file.
+     * @param options The buffering and rotation options to use.
+     */
+    void setup_file_logging(std::string const& path, file_logging_options options = file_logging_options());
+
+    /**
+     * Writes any messages buffered by the file logging backend.
+     */
+    void flush_file_logging();
+
+    /**
+     * Flushes and reopens the log file, e.g. after it was moved away by an external log rotation tool.
+     */
+    void reopen_file_logging();
+
+    /**
+     * Flushes and closes the log file and switches back to the stream logging backend.
+     * Waits for any pending on_rotate callbacks to complete.
+     */
+    void clean_file_logging();
+
+    /**
+     * Options for the native syslog client.
+     */
+    struct syslog_options
+    {
+        /**
+         * Path of the local syslog datagram socket. Ignored if host is set.
+         */
+        std::string socket_path = "/dev/log";
+
+        /**
+         * Host of a remote syslog server to send to over UDP. When empty, socket_path is used.
+         */
+        std::string host;
+
+        /**
+         * Port of the remote syslog server.
+         */
+        uint16_t port = 514;
+
+        /**
+         * Format messages as RFC 5424 rather than the traditional RFC 3164 (BSD) layout.
+         */
+        bool rfc5424 = false;
+
+        /**
+         * SD-ID of the structured data element the logging context is rendered as in RFC 5424 messages.
+         * The default uses the enterprise number reserved for documentation; applications should use their own.
+         */
+        std::string structured_data_id = "context@32473";
+
+        /**
+         * Maximum number of messages queued for sending; messages logged while the queue is full are dropped.
+         */
+        size_t queue_size = 1024;
+
+        /**
+         * Maximum number of messages handed to the kernel in a single call.
+         */
+        size_t batch_size = 64;
+
+        /**
+         * Longest time a queued message waits before being sent. Zero sends every message immediately.
+         */
+        std::chrono::milliseconds flush_interval = std::chrono::milliseconds(100);
+
+        /**
+         * Messages at or above this level are sent immediately, along with anything queued before them.
+         */
+        log_level flush_level = log_level::error;
+    };
+
+    /**
+     * Counters reported by the native syslog client.
+     */
+    struct syslog_stats
+    {
+        /**
+         * Number of messages sent to the syslog socket.
+         */
+        uint64_t sent;
+
+        /**
+         * Number of messages dropped because the queue was full or the socket could not be written.
+         */
+        uint64_t dropped;
+    };
+
+    /**
+     * Configures application to log to syslog using a native client instead of libc's syslog().
+     * The client keeps a persistent socket, formats messages without locales or iostreams, and
+     * sends queued messages in batches from a background thread.
+     * The logging level is set to warning by default.
+     * @param application Application name.
+     * @param facility Syslog facility to log to.
+     * @param options The socket, format and batching options to use.
+     */
+    void setup_native_syslog_logging(const char* application, const std::string& facility, syslog_options options = syslog_options());
+
+    /**
+     * Sends any messages queued by the native syslog client.
+     */
+    void flush_syslog_logging();
+
+    /**
+     * Gets the counters reported by the native syslog client.
+     * @return Returns the number of messages sent and dropped since the client was set up.
+     */
+    syslog_stats get_syslog_stats();
+
+    /**
+     * Stops sending to syslog, flushing and closing the native syslog client if one is set up.
+     */
+    void clean_syslog_logging();
+
     /**
      * Sets the current log level.
      * @param level The new current log level to set.
@@ -227,10 +481,65 @@ namespace leatherman { namespace logging {
     /**
      * Provides a callback for when a message is logged.
      * If the callback returns false, the message will not be logged.
+     * Replaces the callback from any previous call; passing an empty callback removes it.
+     * This is a single subscriber kept alongside any added with add_subscriber.
      * @param callback The callback to call when a message is about to be logged.
      */
     void on_message(std::function<bool(log_level, std::string const&)> callback);
 
+    /**
+     * A set of logging levels, as a bit mask.
+     */
+    using log_level_mask = unsigned int;
+
+    /**
+     * Mask of every logging level.
+     */
+    constexpr log_level_mask all_levels = ~0u;
+
+    /**
+     * Gets the mask for a single logging level.
+     * @param level The logging level.
+     * @return Returns the mask containing only the given level.
+     */
+    constexpr log_level_mask level_mask(log_level level)
+    {
+        return 1u << static_cast<unsigned int>(level);
+    }
+
+    /**
+     * Gets the mask for a logging level and every level above it.
+     * @param level The lowest logging level in the mask.
+     * @return Returns the mask containing the given level and every more severe level.
+     */
+    constexpr log_level_mask levels_at_or_above(log_level level)
+    {
+        return ~(level_mask(level) - 1);
+    }
+
+    /**
+     * Identifies a subscriber added with add_subscriber.
+     */
+    using subscriber_token = uint64_t;
+
+    /**
+     * Adds a callback for when a message at one of the given levels is logged.
+     * Subscribers are called in the order they were added, on the thread logging the message, without any
+     * lock held; they may add and remove subscribers. If any subscriber returns false, the message will not
+     * be logged, though the remaining subscribers are still called.
+     * Throws an invalid_argument if the callback is empty.
+     * @param callback The callback to call when a message is about to be logged.
+     * @param levels The levels of the messages the callback is called for.
+     * @return Returns a token for removing the subscriber.
+     */
+    subscriber_token add_subscriber(std::function<bool(log_level, std::string const&)> callback, log_level_mask levels = all_levels);
+
+    /**
+     * Removes a subscriber. Messages already being logged on other threads may still reach it.
+     * @param token The token returned by add_subscriber.
+     */
+    void remove_subscriber(subscriber_token token);
+
     /**
      * Determines if the given log level is enabled for the given logger.
      * @param level The logging level to check.
@@ -238,6 +547,185 @@ namespace leatherman { namespace logging {
      */
     bool is_enabled(log_level level);
 
+    /**
+     * Adds a key/value pair to the calling thread's logging context for the lifetime of the object.
+     * The context is attached to every message logged by the thread and rendered by the stream, file,
+     * JSON and syslog backends. It's kept in a small fixed-size per-thread buffer, so creating a scope
+     * never allocates; a value that doesn't fit is truncated, and a pair is left out entirely once the
+     * buffer or its entry table is full.
+     * Scopes must be destroyed on the thread that created them, in the reverse order of creation.
+     */
+    class scoped_log_context
+    {
+     public:
+        /**
+         * Adds a key/value pair to the calling thread's logging context.
+         * @param key The key, e.g. "request_id".
+         * @param value The value.
+         */
+        scoped_log_context(boost::string_ref key, boost::string_ref value);
+
+        /**
+         * Removes the pair, and any added after it, from the calling thread's logging context.
+         */
+        ~scoped_log_context();
+
+        /**
+         * Prevents the scope from being copied.
+         */
+        scoped_log_context(scoped_log_context const&) = delete;
+
+        /**
+         * Prevents the scope from being copied.
+         * @returns Returns this scope.
+         */
+        scoped_log_context& operator=(scoped_log_context const&) = delete;
+
+     private:
+        uint16_t _count;
+        uint16_t _size;
+    };
+
+    /**
+     * Gets a copy of the calling thread's logging context, e.g. for a subscriber to forward.
+     * @return Returns the key/value pairs, in the order they were added.
+     */
+    std::vector<std::pair<std::string, std::string>> get_log_context();
+
+    /**
+     * Options for the flight recorder.
+     */
+    struct flight_recorder_options
+    {
+        /**
+         * The lowest level to record. Messages below the current log level but at or above this one are recorded.
+         */
+        log_level level = log_level::trace;
+
+        /**
+         * Number of messages kept per thread; older messages are overwritten.
+         */
+        size_t capacity = 256;
+
+        /**
+         * Longest message, in bytes, that is kept in full; longer messages are truncated.
+         */
+        size_t message_size = 512;
+
+        /**
+         * Dump the recorded messages before any error or fatal message is logged.
+         */
+        bool dump_on_error = true;
+    };
+
+    /**
+     * Starts recording messages that are below the current log level into per-thread ring buffers,
+     * so the context leading up to a failure can be logged after the fact.
+     * Recording a message takes no locks; it costs formatting the message and copying it into the buffer.
+     * Calling this again discards anything recorded so far.
+     * @param options The recording options to use.
+     */
+    void enable_flight_recorder(flight_recorder_options options = flight_recorder_options());
+
+    /**
+     * Stops recording messages and discards anything recorded so far.
+     */
+    void disable_flight_recorder();
+
+    /**
+     * Logs the messages recorded since the last dump, oldest first, to the current logging backend.
+     * Each message keeps its original level and is prefixed with the time it was recorded.
+     * Recorded messages are not passed to subscribers or the on_message callback.
+     */
+    void dump_flight_recorder();
+
+    /**
+     * Determines if the flight recorder records messages at the given level when they're below the current log level.
+     * @param level The logging level to check.
+     * @return Returns true if the flight recorder is enabled and records the logging level, or false if not.
+     */
+    bool is_recording(log_level level);
+
+    /**
+     * Options for limiting the rate of messages logged from each call site of the logging macros.
+     */
+    struct rate_limit_options
+    {
+        /**
+         * Sustained number of messages per second allowed from a single call site. Zero disables rate limiting.
+         */
+        double messages_per_second = 10;
+
+        /**
+         * Number of messages a call site can log in a burst before being limited to the sustained rate.
+         */
+        unsigned int burst = 20;
+
+        /**
+         * Collapse identical consecutive messages from a call site into "last message repeated N times".
+         */
+        bool suppress_duplicates = true;
+
+        /**
+         * Longest time repeated messages are held back before a summary of them is logged.
+         */
+        std::chrono::milliseconds duplicate_interval = std::chrono::milliseconds(10000);
+    };
+
+    /**
+     * Starts limiting the messages logged by each call site of the logging macros.
+     * Messages over the rate are dropped, and a count of them is logged with the next message let through.
+     * Messages logged directly through log() aren't limited.
+     * @param options The rate limiting options to use.
+     */
+    void set_rate_limit(rate_limit_options options = rate_limit_options());
+
+    /**
+     * Stops limiting the messages logged by the logging macros.
+     */
+    void disable_rate_limit();
+
+    /**
+     * Per-call-site state for rate limiting and duplicate suppression, declared by the logging macros.
+     * It's constant-initialized, so declaring it as a local static costs nothing at runtime.
+     */
+    struct call_site
+    {
+        constexpr call_site() :
+            next(0),
+            suppressed(0),
+            last_hash(0),
+            repeats(0),
+            summarized(0)
+        {
+        }
+
+        /**
+         * Theoretical arrival time of the next message, in steady clock nanoseconds.
+         */
+        std::atomic<int64_t> next;
+
+        /**
+         * Number of messages dropped by rate limiting since the last one logged.
+         */
+        std::atomic<uint32_t> suppressed;
+
+        /**
+         * Hash of the last message logged.
+         */
+        std::atomic<size_t> last_hash;
+
+        /**
+         * Number of times the last message was repeated since it was last logged or summarized.
+         */
+        std::atomic<uint32_t> repeats;
+
+        /**
+         * When the last message was logged or summarized, in steady clock nanoseconds.
+         */
+        std::atomic<int64_t> summarized;
+    };
+
     /**
      * Determine if an error has been logged
      * @return Returns true if an error or critical message has been logged
@@ -291,6 +779,89 @@ namespace leatherman { namespace logging {
         log_helper(logger, level, line_num, leatherman::locale::format(fmt, std::forward<TArgs>(args)...));
     }
 
+    /**
+     * Logs a given message to the given logger with the specified line number (if > 0).
+     * Never translates or formats the message, so it's suitable for arbitrary data such as program output.
+     * @param logger The logger to log to.
+     * @param level The logging level to log with.
+     * @param line_num The source line number of the logging call.
+     * @param message The message to log.
+     */
+    static inline void log_raw(const std::string &logger, log_level level, int line_num, std::string const& message)
+    {
+        log_helper(logger, level, line_num, message);
+    }
+
+    /**
+     * Determines if a call site may log another message, counting it as suppressed if not.
+     * @param site The call site.
+     * @param level The logging level of the message.
+     * @return Returns true if the message should be formatted and logged, or false if it's over the rate limit.
+     */
+    bool admit_message(call_site& site, log_level level);
+
+    /**
+     * Logs a given message from a call site, first logging a summary of any messages suppressed before it.
+     * Does no translation on the message.
+     * @param site The call site.
+     * @param logger The logger the message was logged to.
+     * @param level The logging level to log with.
+     * @param line_num The source line number of the logging call.
+     * @param message The message to log.
+     */
+    void log_call_site(call_site& site, const std::string &logger, log_level level, int line_num, std::string const& message);
+
+    /**
+     * Logs a given message from a call site of the logging macros.
+     * If LEATHERMAN_I18N is specified it does translation on the message.
+     * @param site The call site.
+     * @param logger The logger to log to.
+     * @param level The logging level to log with.
+     * @param line_num The source line number of the logging call.
+     * @param msg The message format.
+     */
+    static inline void log(call_site& site, const std::string &logger, log_level level, int line_num, std::string const& msg)
+    {
+        if (admit_message(site, level)) {
+            log_call_site(site, logger, level, line_num, leatherman::locale::translate(msg));
+        }
+    }
+
+    /**
+     * Logs a given message from a call site of the raw logging macros, without translation or formatting.
+     * @param site The call site.
+     * @param logger The logger to log to.
+     * @param level The logging level to log with.
+     * @param line_num The source line number of the logging call.
+     * @param message The message to log.
+     */
+    static inline void log_raw(call_site& site, const std::string &logger, log_level level, int line_num, std::string const& message)
+    {
+        if (admit_message(site, level)) {
+            log_call_site(site, logger, level, line_num, message);
+        }
+    }
+
+    /**
+     * Logs a given format message from a call site of the logging macros.
+     * Messages over the rate limit are dropped before being formatted.
+     * If LEATHERMAN_I18N is specified, does translation on the format string, but not following arguments.
+     * @tparam TArgs The types of the arguments to format the message with.
+     * @param site The call site.
+     * @param logger The logger to log to.
+     * @param level The logging level to log with.
+     * @param line_num The source line number of the logging call.
+     * @param fmt The message format.
+     * @param args The remaining arguments to the message.
+     */
+    template <typename... TArgs>
+    static void log(call_site& site, const std::string &logger, log_level level, int line_num, std::string const& fmt, TArgs... args)
+    {
+        if (admit_message(site, level)) {
+            log_call_site(site, logger, level, line_num, leatherman::locale::format(fmt, std::forward<TArgs>(args)...));
+        }
+    }
+
     /**
      * Starts colorizing for the given log level.
      * This is a no-op on platforms that don't natively support terminal colors.
@@ -310,8 +881,12 @@ namespace leatherman { namespace logging {
     void log_eventlog(log_level level, std::string const& message);
     void log_syslog(log_level level, std::string const& message);
     void log_boost(const std::string &logger, log_level level, int line_num, std::string const& message);
+    void log_file(const std::string &logger, log_level level, int line_num, std::string const& message);
+    void log_json(const std::string &logger, log_level level, int line_num, std::string const& message);
     void enable_event_log(void);
     void disable_event_log(void);
     void enable_syslog(void);
     void disable_syslog(void);
+    void enable_file(void);
+    void disable_file(void);
 }}  // namespace leatherman::logging
@@ -0,0 +1,150 @@
+#include <leatherman/logging/logging.hpp>
+#include <algorithm>
+#include <cstring>
+#include "record.hpp"
+
+using namespace std;
+
+namespace leatherman { namespace logging {
+
+    /**
+     * The calling thread's logging context. It's plain data, so the thread_local needs no
+     * construction or destruction and accessing it is as cheap as the platform allows.
+     */
+    struct log_context
+    {
+        static constexpr size_t max_entries = 16;
+        static constexpr size_t buffer_size = 512;
+
+        struct entry
+        {
+            uint16_t offset;
+            uint16_t key_size;
+            uint16_t value_size;
+        };
+
+        entry entries[max_entries];
+        uint16_t count;
+        uint16_t size;
+        char buffer[buffer_size];
+    };
+
+    static thread_local log_context t_context;
+
+    scoped_log_context::scoped_log_context(boost::string_ref key, boost::string_ref value) :
+        _count(t_context.count),
+        _size(t_context.size)
+    {
+        auto& context = t_context;
+        size_t available = log_context::buffer_size - context.size;
+        if (context.count == log_context::max_entries || key.empty() || key.size() >= available) {
+            return;
+        }
+        auto value_size = min(value.size(), available - key.size());
+
+        auto& entry = context.entries[context.count];
+        entry.offset = context.size;
+        entry.key_size = static_cast<uint16_t>(key.size());
+        entry.value_size = static_cast<uint16_t>(value_size);
+        memcpy(context.buffer + context.size, key.data(), key.size());
+        memcpy(context.buffer + context.size + key.size(), value.data(), value_size);
+        context.size += static_cast<uint16_t>(key.size() + value_size);
+        ++context.count;
+    }
+
+    scoped_log_context::~scoped_log_context()
+    {
+        t_context.count = _count;
+        t_context.size = _size;
+    }
+
+    vector<pair<string, string>> get_log_context()
+    {
+        auto const& context = t_context;
+        vector<pair<string, string>> pairs;
+        pairs.reserve(context.count);
+        for (size_t i = 0; i < context.count; ++i) {
+            auto const& entry = context.entries[i];
+            auto key = context.buffer + entry.offset;
+            pairs.emplace_back(string(key, entry.key_size), string(key + entry.key_size, entry.value_size));
+        }
+        return pairs;
+    }
+
+    bool append_text_context(string& buffer)
+    {
+        auto const& context = t_context;
+        if (context.count == 0) {
+            return false;
+        }
+        buffer += '[';
+        for (size_t i = 0; i < context.count; ++i) {
+            auto const& entry = context.entries[i];
+            auto key = context.buffer + entry.offset;
+            if (i > 0) {
+                buffer += ' ';
+            }
+            buffer.append(key, entry.key_size);
+            buffer += '=';
+            buffer.append(key + entry.key_size, entry.value_size);
+        }
+        buffer += ']';
+        return true;
+    }
+
+    void append_json_context(string& buffer)
+    {
+        auto const& context = t_context;
+        if (context.count == 0) {
+            return;
+        }
+        buffer += ",\"context\":{";
+        for (size_t i = 0; i < context.count; ++i) {
+            auto const& entry = context.entries[i];
+            auto key = context.buffer + entry.offset;
+            if (i > 0) {
+                buffer += ',';
+            }
+            append_json_string(buffer, boost::string_ref(key, entry.key_size));
+            buffer += ':';
+            append_json_string(buffer, boost::string_ref(key + entry.key_size, entry.value_size));
+        }
+        buffer += '}';
+    }
+
+    void append_structured_data(string& buffer, string const& id)
+    {
+        auto const& context = t_context;
+        if (context.count == 0) {
+            buffer += '-';
+            return;
+        }
+        buffer += '[';
+        buffer += id;
+        for (size_t i = 0; i < context.count; ++i) {
+            auto const& entry = context.entries[i];
+            auto key = context.buffer + entry.offset;
+
+            // PARAM-NAME is at most 32 printable characters other than '=', ' ', ']' and '"'.
+            buffer += ' ';
+            for (size_t j = 0; j < min<size_t>(entry.key_size, 32); ++j) {
+                char c = key[j];
+                buffer += (c > ' ' && c < 127 && c != '=' && c != ']' && c != '"') ? c : '_';
+            }
+
+            // PARAM-VALUE must escape '"', '\' and ']'.
+            buffer += "=\"";
+            auto value = key + entry.key_size;
+            for (size_t j = 0; j < entry.value_size; ++j) {
+                char c = value[j];
+                if (c == '"' || c == '\\' || c == ']') {
+                    buffer += '\\';
+                }
+                buffer += c;
+            }
+            buffer += '"';
+        }
+        buffer += ']';
+    }
+
+}}  // namespace leatherman::logging
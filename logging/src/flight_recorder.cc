@@ -0,0 +1,272 @@
+#include <leatherman/logging/logging.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "record.hpp"
+
+// boost includes are not always warning-clean. Disable warnings that
+// cause problems before including the headers, then re-enable the warnings.
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wextra"
+
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/date_time/c_local_time_adjustor.hpp>
+
+#pragma GCC diagnostic pop
+
+using namespace std;
+
+namespace leatherman { namespace logging {
+
+    /**
+     * A fixed-size ring of recorded messages, written only by the thread that owns it.
+     * Each slot is guarded by a sequence lock so a dump on another thread can read it
+     * without stopping the writer: the sequence is odd while the slot is being written,
+     * and a reader that sees it change while copying discards what it copied.
+     */
+    struct recorder_ring
+    {
+        struct slot
+        {
+            atomic<uint32_t> sequence{0};
+            int64_t time = 0;
+            log_level level = log_level::none;
+            int line_num = 0;
+            size_t logger_size = 0;
+            size_t message_size = 0;
+        };
+
+        recorder_ring(uint64_t generation, flight_recorder_options const& options) :
+            generation(generation),
+            slots(options.capacity),
+            text_size(options.message_size),
+            text(options.capacity * options.message_size),
+            next(0)
+        {
+        }
+
+        uint64_t generation;
+        vector<slot> slots;
+        size_t text_size;
+        vector<char> text;
+        size_t next;
+    };
+
+    struct recorded_message
+    {
+        int64_t time;
+        log_level level;
+        int line_num;
+        string logger;
+        string message;
+    };
+
+    // Lowest level recorded, or none when the recorder is disabled. Read on every logging call below the
+    // current log level, so it's kept separate from the rest of the state.
+    static atomic<int> g_record_level{static_cast<int>(log_level::none)};
+
+    // Everything else is guarded by g_recorder_mutex, which is only taken when a thread first records,
+    // when a thread exits, and when dumping or reconfiguring.
+    static mutex g_recorder_mutex;
+    static flight_recorder_options g_recorder_options;
+    static atomic<uint64_t> g_recorder_generation{0};
+    static vector<shared_ptr<recorder_ring>> g_rings;
+    static vector<shared_ptr<recorder_ring>> g_free_rings;
+    static int64_t g_dumped_through = 0;
+
+    // Serializes dumps, so messages from concurrent errors aren't interleaved.
+    static mutex g_dump_mutex;
+
+    /**
+     * Hands the calling thread's ring back to the pool when the thread exits, so its messages can still
+     * be dumped and the ring reused by the next thread that records.
+     */
+    struct ring_holder
+    {
+        ~ring_holder()
+        {
+            if (!ring) {
+                return;
+            }
+            lock_guard<mutex> lock(g_recorder_mutex);
+            if (ring->generation == g_recorder_generation) {
+                g_free_rings.push_back(move(ring));
+            }
+        }
+
+        shared_ptr<recorder_ring> ring;
+    };
+
+    static thread_local ring_holder t_ring;
+
+    static int64_t now_microseconds()
+    {
+        return chrono::duration_cast<chrono::microseconds>(chrono::system_clock::now().time_since_epoch()).count();
+    }
+
+    static recorder_ring* acquire_ring()
+    {
+        auto generation = g_recorder_generation.load();
+        if (t_ring.ring && t_ring.ring->generation == generation) {
+            return t_ring.ring.get();
+        }
+
+        lock_guard<mutex> lock(g_recorder_mutex);
+        if (g_record_level == static_cast<int>(log_level::none)) {
+            return nullptr;
+        }
+        if (!g_free_rings.empty()) {
+            t_ring.ring = move(g_free_rings.back());
+            g_free_rings.pop_back();
+        } else {
+            t_ring.ring = make_shared<recorder_ring>(g_recorder_generation, g_recorder_options);
+            g_rings.push_back(t_ring.ring);
+        }
+        return t_ring.ring.get();
+    }
+
+    void record_message(string const& logger, log_level level, int line_num, string const& message)
+    {
+        auto ring = acquire_ring();
+        if (!ring || ring->slots.empty()) {
+            return;
+        }
+
+        auto index = ring->next++ % ring->slots.size();
+        auto& slot = ring->slots[index];
+        auto text = ring->text.data() + index * ring->text_size;
+
+        auto sequence = slot.sequence.load(memory_order_relaxed);
+        slot.sequence.store(sequence + 1, memory_order_relaxed);
+        atomic_thread_fence(memory_order_release);
+
+        slot.time = now_microseconds();
+        slot.level = level;
+        slot.line_num = line_num;
+        slot.logger_size = min(logger.size(), ring->text_size);
+        slot.message_size = min(message.size(), ring->text_size - slot.logger_size);
+        memcpy(text, logger.data(), slot.logger_size);
+        memcpy(text + slot.logger_size, message.data(), slot.message_size);
+
+        slot.sequence.store(sequence + 2, memory_order_release);
+    }
+
+    static void collect(recorder_ring& ring, int64_t after, vector<recorded_message>& messages)
+    {
+        for (size_t i = 0; i < ring.slots.size(); ++i) {
+            auto& slot = ring.slots[i];
+            auto text = ring.text.data() + i * ring.text_size;
+
+            auto before = slot.sequence.load(memory_order_acquire);
+            if (before == 0 || (before & 1) || slot.time <= after) {
+                // Never written, being written right now, or already dumped.
+                continue;
+            }
+            recorded_message recorded;
+            recorded.time = slot.time;
+            recorded.level = slot.level;
+            recorded.line_num = slot.line_num;
+            auto logger_size = min(slot.logger_size, ring.text_size);
+            auto message_size = min(slot.message_size, ring.text_size - logger_size);
+            recorded.logger.assign(text, logger_size);
+            recorded.message.assign(text + logger_size, message_size);
+
+            atomic_thread_fence(memory_order_acquire);
+            if (slot.sequence.load(memory_order_relaxed) != before) {
+                // Overwritten while copying; the newer message wasn't around when the dump started anyway.
+                continue;
+            }
+            messages.push_back(move(recorded));
+        }
+    }
+
+    static string recorded_prefix(int64_t time)
+    {
+        using namespace boost::posix_time;
+        using local_adjustor = boost::date_time::c_local_adjustor<ptime>;
+
+        auto local = local_adjustor::utc_to_local(from_time_t(0) + microseconds(time));
+        auto time_of_day = local.time_of_day();
+        string prefix = "[recorded at ";
+        append_number(prefix, time_of_day.hours(), 2);
+        prefix += ':';
+        append_number(prefix, time_of_day.minutes(), 2);
+        prefix += ':';
+        append_number(prefix, time_of_day.seconds(), 2);
+        prefix += '.';
+        append_number(prefix, static_cast<unsigned int>(time % 1000000), 6);
+        prefix += "] ";
+        return prefix;
+    }
+
+    void enable_flight_recorder(flight_recorder_options options)
+    {
+        lock_guard<mutex> lock(g_recorder_mutex);
+        g_recorder_options = move(options);
+        g_rings.clear();
+        g_free_rings.clear();
+        g_dumped_through = 0;
+        // Threads notice the new generation on their next message and pick up a ring with the new options.
+        ++g_recorder_generation;
+        g_record_level = static_cast<int>(g_recorder_options.level);
+    }
+
+    void disable_flight_recorder()
+    {
+        lock_guard<mutex> lock(g_recorder_mutex);
+        g_record_level = static_cast<int>(log_level::none);
+        g_rings.clear();
+        g_free_rings.clear();
+        ++g_recorder_generation;
+    }
+
+    bool is_recording(log_level level)
+    {
+        auto lowest = g_record_level.load(memory_order_relaxed);
+        return lowest != static_cast<int>(log_level::none) && static_cast<int>(level) >= lowest;
+    }
+
+    void dump_flight_recorder()
+    {
+        lock_guard<mutex> dump_lock(g_dump_mutex);
+
+        vector<recorded_message> messages;
+        {
+            lock_guard<mutex> lock(g_recorder_mutex);
+            for (auto const& ring : g_rings) {
+                collect(*ring, g_dumped_through, messages);
+            }
+            for (auto const& message : messages) {
+                g_dumped_through = max(g_dumped_through, message.time);
+            }
+        }
+
+        // Stable, so messages from one thread recorded in the same microsecond keep their order.
+        stable_sort(messages.begin(), messages.end(), [](recorded_message const& lhs, recorded_message const& rhs) {
+            return lhs.time < rhs.time;
+        });
+
+        for (auto const& message : messages) {
+            log_recorded(message.logger, message.level, message.line_num, recorded_prefix(message.time) + message.message);
+        }
+    }
+
+    void dump_flight_recorder_on_error()
+    {
+        if (g_record_level.load(memory_order_relaxed) == static_cast<int>(log_level::none)) {
+            return;
+        }
+        {
+            lock_guard<mutex> lock(g_recorder_mutex);
+            if (!g_recorder_options.dump_on_error) {
+                return;
+            }
+        }
+        dump_flight_recorder();
+    }
+
+}}  // namespace leatherman::logging
@@ -1,6 +1,8 @@
 #include <leatherman/logging/logging.hpp>
 #include <leatherman/locale/locale.hpp>
+#include <mutex>
 #include <vector>
+#include "record.hpp"
 
 // Mark string for translation (alias for leatherman::locale::format)
 using leatherman::locale::_;
@@ -31,12 +33,19 @@ namespace sinks = boost::log::sinks;
 
 namespace leatherman { namespace logging {
 
-    static function<bool(log_level, string const&)> g_callback;
     static log_level g_level = log_level::none;
-    static logging_backend g_backend = logging_backend::file;
+    static logging_backend g_backend = logging_backend::stream;
     static bool g_colorize = false;
     static bool g_error_logged = false;
 
+    static mutex g_json_mutex;
+    static ostream* g_json_stream = nullptr;
+    static string g_json_fields;
+    static string g_json_buffer;
+
+    // Set while the flight recorder writes messages that are below the current log level.
+    static thread_local bool t_replaying = false;
+
     namespace lth_locale = leatherman::locale;
 
     class color_writer : public sinks::basic_sink_backend<sinks::synchronized_feeding>
@@ -54,7 +63,7 @@ namespace leatherman { namespace logging {
     {
         auto level = boost::log::extract<log_level>("Severity", rec);
 
-        if (!is_enabled(*level)) {
+        if (!t_replaying && !is_enabled(*level)) {
             return;
         }
 
@@ -69,6 +78,11 @@ namespace leatherman { namespace logging {
         if (line_num) {
             _dst << ":" << *line_num;
         }
+        // The sink is synchronous, so this runs on the thread that logged the message.
+        string context;
+        if (append_text_context(context)) {
+            _dst << " " << context;
+        }
         _dst << " - ";
         colorize(_dst, *level);
         _dst << *message;
@@ -86,6 +100,7 @@ namespace leatherman { namespace logging {
         using sink_t = sinks::synchronous_sink<color_writer>;
         boost::shared_ptr<sink_t> sink = boost::make_shared<sink_t>(boost::make_shared<color_writer>(&dst));
         core->add_sink(sink);
+        g_backend = logging_backend::stream;
 
 
 #ifdef LEATHERMAN_USE_LOCALES
@@ -110,6 +125,23 @@ namespace leatherman { namespace logging {
         g_colorize = color_supported(dst);
     }
 
+    // cppcheck-suppress passedByValue
+    void setup_json_logging(ostream &dst, json_log_fields fields)
+    {
+        auto core = boost::log::core::get();
+        core->remove_all_sinks();
+
+        {
+            lock_guard<mutex> lock(g_json_mutex);
+            g_json_stream = &dst;
+            g_json_fields = render_json_fields(fields);
+        }
+        g_backend = logging_backend::json;
+
+        // Default to the warning level
+        set_level(log_level::warning);
+    }
+
     // This version exists for binary compatibility only.
     void setup_logging(ostream &dst, string locale, string domain)
     {
@@ -151,21 +183,13 @@ namespace leatherman { namespace logging {
         g_error_logged = false;
     }
 
-    // cppcheck-suppress passedByValue
-    void on_message(function<bool(log_level, string const&)> callback)
+    void set_error_logged()
     {
-        g_callback = callback;
+        g_error_logged = true;
     }
 
-    void log_helper(const string &logger, log_level level, int line_num, string const& message)
+    static void dispatch(const string &logger, log_level level, int line_num, string const& message)
     {
-        if (level >= log_level::error) {
-            g_error_logged = true;
-        }
-        if (!is_enabled(level) || (g_callback && !g_callback(level, message))) {
-            return;
-        }
-
         switch (g_backend) {
         case logging_backend::eventlog:
             log_eventlog(level, message);
@@ -173,12 +197,47 @@ namespace leatherman { namespace logging {
         case logging_backend::syslog:
             log_syslog(level, message);
             break;
+        case logging_backend::file:
+            log_file(logger, level, line_num, message);
+            break;
+        case logging_backend::json:
+            log_json(logger, level, line_num, message);
+            break;
         default:
             log_boost(logger, level, line_num, message);
             break;
         }
     }
 
+    void log_helper(const string &logger, log_level level, int line_num, string const& message)
+    {
+        if (level >= log_level::error) {
+            g_error_logged = true;
+        }
+        if (!is_enabled(level)) {
+            if (is_recording(level)) {
+                record_message(logger, level, line_num, message);
+            }
+            return;
+        }
+        if (!notify_subscribers(level, message)) {
+            return;
+        }
+        if (level >= log_level::error) {
+            // Log what led up to the error before the error itself.
+            dump_flight_recorder_on_error();
+        }
+
+        dispatch(logger, level, line_num, message);
+    }
+
+    void log_recorded(const string &logger, log_level level, int line_num, string const& message)
+    {
+        t_replaying = true;
+        dispatch(logger, level, line_num, message);
+        t_replaying = false;
+    }
+
     void log_boost(const string &logger, log_level level, int line_num, string const& message)
     {
         src::logger slg;
@@ -191,6 +250,187 @@ namespace leatherman { namespace logging {
         BOOST_LOG(slg) << message;
     }
 
+    char const* level_name(log_level level)
+    {
+        switch (level) {
+        case log_level::trace:
+            return "TRACE";
+        case log_level::debug:
+            return "DEBUG";
+        case log_level::info:
+            return "INFO";
+        case log_level::warning:
+            return "WARN";
+        case log_level::error:
+            return "ERROR";
+        case log_level::fatal:
+            return "FATAL";
+        default:
+            return "";
+        }
+    }
+
+    void append_number(string& buffer, unsigned int value, size_t width)
+    {
+        char digits[16];
+        size_t count = 0;
+        do {
+            digits[count++] = static_cast<char>('0' + value % 10);
+            value /= 10;
+        } while (value && count < sizeof(digits));
+        for (; count < width; --width) {
+            buffer += '0';
+        }
+        while (count) {
+            buffer += digits[--count];
+        }
+    }
+
+    void append_timestamp(string& buffer, char separator)
+    {
+        // Formatted by hand rather than through to_simple_string, which allocates and
+        // omits the fractional seconds when they happen to be zero.
+        auto now = boost::posix_time::microsec_clock::local_time();
+        auto date = now.date().year_month_day();
+        auto time = now.time_of_day();
+        append_number(buffer, date.year, 4);
+        buffer += '-';
+        append_number(buffer, date.month.as_number(), 2);
+        buffer += '-';
+        append_number(buffer, date.day, 2);
+        buffer += separator;
+        append_number(buffer, time.hours(), 2);
+        buffer += ':';
+        append_number(buffer, time.minutes(), 2);
+        buffer += ':';
+        append_number(buffer, time.seconds(), 2);
+        buffer += '.';
+        append_number(buffer, static_cast<unsigned int>(time.fractional_seconds() * 1000000 / time.ticks_per_second()), 6);
+    }
+
+    void append_text_record(string& buffer, string const& logger, log_level level, int line_num, string const& message)
+    {
+        append_timestamp(buffer);
+        buffer += ' ';
+        auto name = level_name(level);
+        buffer += name;
+        for (auto len = char_traits<char>::length(name); len < 5; ++len) {
+            buffer += ' ';
+        }
+        buffer += ' ';
+        buffer += logger;
+        if (line_num > 0) {
+            buffer += ':';
+            append_number(buffer, static_cast<unsigned int>(line_num), 0);
+        }
+        auto size = buffer.size();
+        buffer += ' ';
+        if (!append_text_context(buffer)) {
+            buffer.resize(size);
+        }
+        buffer += " - ";
+        buffer += message;
+        buffer += '\n';
+    }
+
+    void log_json(const string &logger, log_level level, int line_num, string const& message)
+    {
+        lock_guard<mutex> lock(g_json_mutex);
+        if (!g_json_stream) {
+            return;
+        }
+        g_json_buffer.clear();
+        append_json_record(g_json_buffer, logger, level, line_num, message, g_json_fields);
+        g_json_stream->write(g_json_buffer.data(), g_json_buffer.size());
+        if (level >= log_level::warning) {
+            g_json_stream->flush();
+        }
+    }
+
+    void append_json_string(string& buffer, boost::string_ref value)
+    {
+        static char const hex[] = "0123456789abcdef";
+
+        buffer += '"';
+        auto begin = value.data();
+        auto end = begin + value.size();
+        auto run = begin;
+        for (auto it = begin; it != end; ++it) {
+            auto c = static_cast<unsigned char>(*it);
+            if (c >= 0x20 && c != '"' && c != '\\') {
+                continue;
+            }
+            // Copy the run of characters that don't need escaping in one go.
+            buffer.append(run, it);
+            run = it + 1;
+            buffer += '\\';
+            switch (c) {
+            case '"':
+                buffer += '"';
+                break;
+            case '\\':
+                buffer += '\\';
+                break;
+            case '\n':
+                buffer += 'n';
+                break;
+            case '\r':
+                buffer += 'r';
+                break;
+            case '\t':
+                buffer += 't';
+                break;
+            case '\b':
+                buffer += 'b';
+                break;
+            case '\f':
+                buffer += 'f';
+                break;
+            default:
+                buffer += "u00";
+                buffer += hex[c >> 4];
+                buffer += hex[c & 0xf];
+                break;
+            }
+        }
+        buffer.append(run, end);
+        buffer += '"';
+    }
+
+    string render_json_fields(json_log_fields const& fields)
+    {
+        string rendered;
+        for (auto const& field : fields) {
+            rendered += ',';
+            append_json_string(rendered, field.first);
+            rendered += ':';
+            append_json_string(rendered, field.second);
+        }
+        return rendered;
+    }
+
+    void append_json_record(string& buffer, string const& logger, log_level level, int line_num,
+                            string const& message, string const& fields)
+    {
+        buffer += "{\"timestamp\":\"";
+        append_timestamp(buffer, 'T');
+        buffer += "\",\"level\":\"";
+        buffer += level_name(level);
+        buffer += "\",\"namespace\":";
+        append_json_string(buffer, logger);
+        if (line_num > 0) {
+            buffer += ",\"line\":";
+            append_number(buffer, static_cast<unsigned int>(line_num));
+        }
+        buffer += ",\"thread\":";
+        buffer += to_string(current_thread_id());
+        buffer += ",\"message\":";
+        append_json_string(buffer, message);
+        append_json_context(buffer);
+        buffer += fields;
+        buffer += "}\n";
+    }
+
     istream& operator>>(istream& in, log_level& level)
     {
         string value;
@@ -249,7 +489,7 @@ namespace leatherman { namespace logging {
 
     void disable_event_log()
     {
-        g_backend = logging_backend::file;
+        g_backend = logging_backend::stream;
     }
 
     void enable_syslog()
@@ -258,8 +498,18 @@ namespace leatherman { namespace logging {
     }
 
     void disable_syslog()
+    {
+        g_backend = logging_backend::stream;
+    }
+
+    void enable_file()
     {
         g_backend = logging_backend::file;
     }
 
+    void disable_file()
+    {
+        g_backend = logging_backend::stream;
+    }
+
 }}  // namespace leatherman::logging
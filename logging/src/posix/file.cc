@@ -0,0 +1,344 @@
+#include <leatherman/logging/logging.hpp>
+#include <leatherman/locale/locale.hpp>
+#include <leatherman/util/posix/scoped_descriptor.hpp>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include "../record.hpp"
+
+// Mark string for translation (alias for leatherman::locale::format)
+using leatherman::locale::_;
+
+using namespace std;
+using leatherman::util::posix::scoped_descriptor;
+
+namespace leatherman { namespace logging {
+
+    using steady = chrono::steady_clock;
+
+    // Set from the SIGHUP handler, so it can only be a lock-free flag; the reopen itself
+    // happens on the next write or flusher wakeup.
+    static atomic<bool> g_reopen_requested{false};
+
+    static void request_reopen(int)
+    {
+        g_reopen_requested = true;
+    }
+
+    static void write_all(int fd, iovec* iov, int count)
+    {
+        while (count > 0) {
+            ssize_t written = writev(fd, iov, count);
+            if (written < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                // There's nowhere left to report a failure to write the log, so drop the data.
+                return;
+            }
+            while (count > 0 && static_cast<size_t>(written) >= iov->iov_len) {
+                written -= iov->iov_len;
+                ++iov;
+                --count;
+            }
+            if (count > 0) {
+                iov->iov_base = static_cast<char*>(iov->iov_base) + written;
+                iov->iov_len -= written;
+            }
+        }
+    }
+
+    static int open_log(string const& path, bool truncate)
+    {
+        return open(path.c_str(), O_WRONLY | O_CREAT | O_CLOEXEC | (truncate ? O_TRUNC : O_APPEND), 0644);
+    }
+
+    // All state is guarded by g_file_mutex, which is also held while the sink is installed or removed.
+    static mutex g_file_mutex;
+
+    class file_sink
+    {
+     public:
+        file_sink(string path, file_logging_options options);
+        ~file_sink();
+
+        void write(string const& logger, log_level level, int line_num, string const& message);
+        void flush();
+        void reopen();
+
+     private:
+        void write_buffer(string const* record = nullptr);
+        bool rotation_due(size_t incoming) const;
+        void rotate();
+        void run_flusher();
+
+        string _path;
+        file_logging_options _options;
+        scoped_descriptor _fd;
+        string _buffer;
+        string _record;
+        string _json_fields;
+        uint64_t _size;
+        steady::time_point _opened;
+        steady::time_point _oldest;
+        vector<future<void>> _rotated;
+        struct sigaction _previous_sighup;
+        bool _stopping;
+        condition_variable _wakeup;
+        thread _flusher;
+    };
+
+    file_sink::file_sink(string path, file_logging_options options) :
+        _path(move(path)),
+        _options(move(options)),
+        _size(0),
+        _stopping(false)
+    {
+        int fd = open_log(_path, false);
+        if (fd < 0) {
+            throw runtime_error(_("failed to open log file '{1}': {2}.", _path, strerror(errno)));
+        }
+        _fd = scoped_descriptor(fd);
+
+        struct stat info;
+        if (fstat(fd, &info) == 0) {
+            _size = static_cast<uint64_t>(info.st_size);
+        }
+        _opened = steady::now();
+        _buffer.reserve(_options.buffer_size);
+        _json_fields = render_json_fields(_options.json_fields);
+
+        if (_options.reopen_on_sighup) {
+            struct sigaction action;
+            memset(&action, 0, sizeof(action));
+            action.sa_handler = request_reopen;
+            action.sa_flags = SA_RESTART;
+            sigemptyset(&action.sa_mask);
+            sigaction(SIGHUP, &action, &_previous_sighup);
+        }
+
+        if (_options.flush_interval.count() > 0) {
+            _flusher = thread(&file_sink::run_flusher, this);
+        }
+    }
+
+    file_sink::~file_sink()
+    {
+        {
+            lock_guard<mutex> lock(g_file_mutex);
+            _stopping = true;
+            write_buffer();
+        }
+        _wakeup.notify_all();
+        if (_flusher.joinable()) {
+            _flusher.join();
+        }
+        if (_options.reopen_on_sighup) {
+            sigaction(SIGHUP, &_previous_sighup, nullptr);
+        }
+        for (auto& rotated : _rotated) {
+            rotated.wait();
+        }
+    }
+
+    void file_sink::write(string const& logger, log_level level, int line_num, string const& message)
+    {
+        if (g_reopen_requested.exchange(false)) {
+            reopen();
+        }
+
+        _record.clear();
+        if (_options.json) {
+            append_json_record(_record, logger, level, line_num, message, _json_fields);
+        } else {
+            append_text_record(_record, logger, level, line_num, message);
+        }
+
+        if (rotation_due(_record.size())) {
+            write_buffer();
+            rotate();
+        }
+
+        if (_buffer.size() + _record.size() > _options.buffer_size) {
+            // Write what's buffered and the new record with a single writev.
+            write_buffer(&_record);
+        } else {
+            if (_buffer.empty()) {
+                _oldest = steady::now();
+            }
+            _buffer += _record;
+        }
+
+        if (level >= _options.flush_level || _options.flush_interval.count() <= 0) {
+            write_buffer();
+        }
+    }
+
+    void file_sink::flush()
+    {
+        write_buffer();
+    }
+
+    void file_sink::reopen()
+    {
+        write_buffer();
+        int fd = open_log(_path, false);
+        if (fd < 0) {
+            // Keep writing to the old descriptor rather than losing messages.
+            return;
+        }
+        _fd = scoped_descriptor(fd);
+        struct stat info;
+        _size = fstat(fd, &info) == 0 ? static_cast<uint64_t>(info.st_size) : 0;
+        _opened = steady::now();
+    }
+
+    void file_sink::write_buffer(string const* record)
+    {
+        iovec iov[2];
+        int count = 0;
+        if (!_buffer.empty()) {
+            iov[count].iov_base = const_cast<char*>(_buffer.data());
+            iov[count].iov_len = _buffer.size();
+            ++count;
+        }
+        if (record && !record->empty()) {
+            iov[count].iov_base = const_cast<char*>(record->data());
+            iov[count].iov_len = record->size();
+            ++count;
+        }
+        if (count == 0) {
+            return;
+        }
+        _size += _buffer.size() + (record ? record->size() : 0);
+        write_all(_fd, iov, count);
+        _buffer.clear();
+    }
+
+    bool file_sink::rotation_due(size_t incoming) const
+    {
+        uint64_t pending = _size + _buffer.size();
+        if (_options.rotate_size > 0 && pending > 0 && pending + incoming > _options.rotate_size) {
+            return true;
+        }
+        return _options.rotate_interval.count() > 0 && steady::now() - _opened >= _options.rotate_interval;
+    }
+
+    void file_sink::rotate()
+    {
+        string rotated;
+        if (_options.rotate_count > 0) {
+            // Shift <path>.N-1 to <path>.N, dropping the oldest, then move the current file to <path>.1.
+            // The open descriptor follows the rename, so nothing is lost if the new file can't be created.
+            for (auto i = _options.rotate_count - 1; i > 0; --i) {
+                rename((_path + "." + to_string(i)).c_str(), (_path + "." + to_string(i + 1)).c_str());
+            }
+            rotated = _path + ".1";
+            rename(_path.c_str(), rotated.c_str());
+        }
+
+        int fd = open_log(_path, _options.rotate_count == 0);
+        if (fd < 0) {
+            return;
+        }
+        _fd = scoped_descriptor(fd);
+        _size = 0;
+        _opened = steady::now();
+
+        if (!rotated.empty() && _options.on_rotate) {
+            _rotated.erase(remove_if(_rotated.begin(), _rotated.end(), [](future<void> const& f) {
+                return f.wait_for(chrono::seconds(0)) == future_status::ready;
+            }), _rotated.end());
+            _rotated.emplace_back(async(launch::async, _options.on_rotate, move(rotated)));
+        }
+    }
+
+    void file_sink::run_flusher()
+    {
+        unique_lock<mutex> lock(g_file_mutex);
+        while (!_stopping) {
+            if (_buffer.empty()) {
+                _wakeup.wait_for(lock, _options.flush_interval);
+            } else {
+                _wakeup.wait_until(lock, _oldest + _options.flush_interval);
+            }
+            if (_stopping) {
+                break;
+            }
+            if (g_reopen_requested.exchange(false)) {
+                reopen();
+            }
+            if (!_buffer.empty() && steady::now() - _oldest >= _options.flush_interval) {
+                write_buffer();
+            }
+            if (_options.rotate_interval.count() > 0 && rotation_due(0)) {
+                rotate();
+            }
+        }
+    }
+
+    static unique_ptr<file_sink> g_file_sink;
+
+    void setup_file_logging(string const& path, file_logging_options options)
+    {
+        unique_ptr<file_sink> sink(new file_sink(path, move(options)));
+        {
+            lock_guard<mutex> lock(g_file_mutex);
+            swap(sink, g_file_sink);
+        }
+        // The previous sink, if any, is flushed and stopped outside the lock.
+        sink.reset();
+
+        // Default to the warning level
+        set_level(log_level::warning);
+        enable_file();
+    }
+
+    void flush_file_logging()
+    {
+        lock_guard<mutex> lock(g_file_mutex);
+        if (g_file_sink) {
+            g_file_sink->flush();
+        }
+    }
+
+    void reopen_file_logging()
+    {
+        lock_guard<mutex> lock(g_file_mutex);
+        if (g_file_sink) {
+            g_file_sink->reopen();
+        }
+    }
+
+    void clean_file_logging()
+    {
+        unique_ptr<file_sink> sink;
+        {
+            lock_guard<mutex> lock(g_file_mutex);
+            swap(sink, g_file_sink);
+            disable_file();
+        }
+        sink.reset();
+    }
+
+    void log_file(string const& logger, log_level level, int line_num, string const& message)
+    {
+        lock_guard<mutex> lock(g_file_mutex);
+        if (g_file_sink) {
+            g_file_sink->write(logger, level, line_num, message);
+        }
+    }
+
+}}  // namespace leatherman::logging
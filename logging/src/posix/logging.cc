@@ -1,7 +1,13 @@
 #include <leatherman/logging/logging.hpp>
 #include <boost/nowide/iostream.hpp>
+#include <pthread.h>
 #include <unistd.h>
 #include <syslog.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+#include "../record.hpp"
+#include "syslog.hpp"
 
 using namespace std;
 
@@ -39,6 +45,19 @@ namespace leatherman { namespace logging {
         return (&dst == &cout && isatty(fileno(stdout))) || (&dst == &cerr && isatty(fileno(stderr)));
     }
 
+    uint64_t current_thread_id()
+    {
+#if defined(__linux__)
+        return static_cast<uint64_t>(syscall(SYS_gettid));
+#elif defined(__APPLE__)
+        uint64_t id = 0;
+        pthread_threadid_np(nullptr, &id);
+        return id;
+#else
+        return static_cast<uint64_t>(reinterpret_cast<uintptr_t>(pthread_self()));
+#endif
+    }
+
     void log_eventlog(log_level level, string const& message) {
         throw runtime_error("eventlog is available only on windows");
     }
@@ -80,6 +99,7 @@ namespace leatherman { namespace logging {
         syslog_facility syslog_facility = string_to_syslog_facility(facility);
         int fac = static_cast<int>(syslog_facility);
 
+        clean_native_syslog();
         openlog(application, LOG_PID | LOG_NDELAY, fac);
 
         // Default to the warning level
@@ -107,11 +127,20 @@ namespace leatherman { namespace logging {
     }
 
     void log_syslog(log_level level, string const &message) {
-        if (level != log_level::none) {
+        if (level != log_level::none && !log_native_syslog(level, message)) {
             int severity = log_level_to_severity(level);
-            syslog(severity, "%s", message.c_str());
+            string context;
+            if (append_text_context(context)) {
+                syslog(severity, "%s %s", context.c_str(), message.c_str());
+            } else {
+                syslog(severity, "%s", message.c_str());
+            }
         }
     }
 
-    void clean_syslog_logging() { closelog(); }
+    void clean_syslog_logging()
+    {
+        clean_native_syslog();
+        closelog();
+    }
 }}  // namespace leatherman::logging
@@ -0,0 +1,422 @@
+#include <leatherman/logging/logging.hpp>
+#include <leatherman/locale/locale.hpp>
+#include <leatherman/util/posix/scoped_descriptor.hpp>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <ctime>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "../record.hpp"
+#include "syslog.hpp"
+
+// Mark string for translation (alias for leatherman::locale::format)
+using leatherman::locale::_;
+
+using namespace std;
+using leatherman::util::posix::scoped_descriptor;
+
+namespace leatherman { namespace logging {
+
+    using steady = chrono::steady_clock;
+
+    class syslog_client
+    {
+     public:
+        syslog_client(string application, int facility, syslog_options options);
+        ~syslog_client();
+
+        void log(log_level level, string const& message);
+        void flush();
+        syslog_stats stats() const;
+
+     private:
+        void format(string& record, int severity, string const& message) const;
+        void connect_socket();
+        void send(size_t count);
+        void run_flusher();
+
+        string _application;
+        string _hostname;
+        unsigned int _pid;
+        int _facility;
+        syslog_options _options;
+        sockaddr_storage _address;
+        socklen_t _address_size;
+
+        // Guards the queue of formatted messages waiting to be sent.
+        mutex _mutex;
+        vector<string> _pending;
+        size_t _pending_count;
+        steady::time_point _oldest;
+        bool _stopping;
+        condition_variable _wakeup;
+
+        // Guards the socket and the messages currently being sent. Messages are swapped
+        // out of the queue so logging threads don't wait on the socket.
+        mutex _send_mutex;
+        scoped_descriptor _socket;
+        vector<string> _sending;
+        vector<iovec> _iov;
+#ifdef HAS_SENDMMSG
+        vector<mmsghdr> _messages;
+#endif
+
+        atomic<uint64_t> _sent;
+        atomic<uint64_t> _dropped;
+        thread _flusher;
+    };
+
+    syslog_client::syslog_client(string application, int facility, syslog_options options) :
+        _application(move(application)),
+        _pid(static_cast<unsigned int>(getpid())),
+        _facility(facility),
+        _options(move(options)),
+        _address_size(0),
+        _pending_count(0),
+        _stopping(false),
+        _sent(0),
+        _dropped(0)
+    {
+        _options.queue_size = max<size_t>(_options.queue_size, 1);
+        _options.batch_size = max<size_t>(min(_options.batch_size, _options.queue_size), 1);
+
+        memset(&_address, 0, sizeof(_address));
+        if (_options.host.empty()) {
+            auto address = reinterpret_cast<sockaddr_un*>(&_address);
+            if (_options.socket_path.size() >= sizeof(address->sun_path)) {
+                throw runtime_error(_("syslog socket path '{1}' is too long.", _options.socket_path));
+            }
+            address->sun_family = AF_UNIX;
+            strncpy(address->sun_path, _options.socket_path.c_str(), sizeof(address->sun_path) - 1);
+            _address_size = sizeof(sockaddr_un);
+        } else {
+            addrinfo hints;
+            memset(&hints, 0, sizeof(hints));
+            hints.ai_family = AF_UNSPEC;
+            hints.ai_socktype = SOCK_DGRAM;
+            addrinfo* result = nullptr;
+            int error = getaddrinfo(_options.host.c_str(), to_string(_options.port).c_str(), &hints, &result);
+            if (error != 0 || !result) {
+                throw runtime_error(_("failed to resolve syslog host '{1}': {2}.", _options.host, gai_strerror(error)));
+            }
+            memcpy(&_address, result->ai_addr, result->ai_addrlen);
+            _address_size = result->ai_addrlen;
+            freeaddrinfo(result);
+        }
+
+        char hostname[256] = {};
+        _hostname = gethostname(hostname, sizeof(hostname) - 1) == 0 ? hostname : "-";
+
+        _pending.resize(_options.queue_size);
+        _sending.resize(_options.queue_size);
+        _iov.resize(_options.batch_size);
+#ifdef HAS_SENDMMSG
+        _messages.resize(_options.batch_size);
+#endif
+
+        {
+            // Connect eagerly like openlog(LOG_NDELAY); failures are retried on the next send.
+            lock_guard<mutex> lock(_send_mutex);
+            connect_socket();
+        }
+
+        if (_options.flush_interval.count() > 0) {
+            _flusher = thread(&syslog_client::run_flusher, this);
+        }
+    }
+
+    syslog_client::~syslog_client()
+    {
+        {
+            lock_guard<mutex> lock(_mutex);
+            _stopping = true;
+        }
+        _wakeup.notify_all();
+        if (_flusher.joinable()) {
+            _flusher.join();
+        }
+        flush();
+    }
+
+    void syslog_client::log(log_level level, string const& message)
+    {
+        bool immediate = level >= _options.flush_level || _options.flush_interval.count() <= 0;
+        bool wake = false;
+        {
+            lock_guard<mutex> lock(_mutex);
+            if (_pending_count == _pending.size()) {
+                ++_dropped;
+                return;
+            }
+            auto& record = _pending[_pending_count];
+            record.clear();
+            format(record, log_level_to_severity(level), message);
+            if (_pending_count++ == 0) {
+                _oldest = steady::now();
+                wake = true;
+            }
+            wake = wake || _pending_count == _options.batch_size;
+        }
+
+        if (immediate) {
+            flush();
+        } else if (wake) {
+            _wakeup.notify_one();
+        }
+    }
+
+    void syslog_client::flush()
+    {
+        lock_guard<mutex> send_lock(_send_mutex);
+        size_t count;
+        {
+            lock_guard<mutex> lock(_mutex);
+            swap(_pending, _sending);
+            count = _pending_count;
+            _pending_count = 0;
+        }
+        send(count);
+    }
+
+    syslog_stats syslog_client::stats() const
+    {
+        return { _sent.load(), _dropped.load() };
+    }
+
+    void syslog_client::format(string& record, int severity, string const& message) const
+    {
+        static char const* const months[] = {
+            "Jan", "Feb", "Mar", "Apr", "May", "Jun", "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"
+        };
+
+        auto now = chrono::system_clock::now();
+        time_t seconds = chrono::system_clock::to_time_t(now);
+        tm fields;
+
+        record += '<';
+        append_number(record, static_cast<unsigned int>(_facility | severity));
+        record += '>';
+
+        if (_options.rfc5424) {
+            // <PRI>1 TIMESTAMP HOSTNAME APP-NAME PROCID MSGID STRUCTURED-DATA MSG, in UTC.
+            gmtime_r(&seconds, &fields);
+            auto micros = chrono::duration_cast<chrono::microseconds>(now.time_since_epoch()).count() % 1000000;
+            record += "1 ";
+            append_number(record, static_cast<unsigned int>(fields.tm_year + 1900), 4);
+            record += '-';
+            append_number(record, static_cast<unsigned int>(fields.tm_mon + 1), 2);
+            record += '-';
+            append_number(record, static_cast<unsigned int>(fields.tm_mday), 2);
+            record += 'T';
+            append_number(record, static_cast<unsigned int>(fields.tm_hour), 2);
+            record += ':';
+            append_number(record, static_cast<unsigned int>(fields.tm_min), 2);
+            record += ':';
+            append_number(record, static_cast<unsigned int>(fields.tm_sec), 2);
+            record += '.';
+            append_number(record, static_cast<unsigned int>(micros), 6);
+            record += "Z ";
+            record += _hostname;
+            record += ' ';
+            record += _application;
+            record += ' ';
+            append_number(record, _pid);
+            record += " - ";
+            append_structured_data(record, _options.structured_data_id);
+            record += ' ';
+        } else {
+            // <PRI>Mmm dd hh:mm:ss [HOSTNAME ]TAG[PID]: MSG, in local time. The hostname is
+            // left out for the local socket, as libc's syslog() does.
+            localtime_r(&seconds, &fields);
+            record += months[fields.tm_mon];
+            record += ' ';
+            if (fields.tm_mday < 10) {
+                record += ' ';
+            }
+            append_number(record, static_cast<unsigned int>(fields.tm_mday));
+            record += ' ';
+            append_number(record, static_cast<unsigned int>(fields.tm_hour), 2);
+            record += ':';
+            append_number(record, static_cast<unsigned int>(fields.tm_min), 2);
+            record += ':';
+            append_number(record, static_cast<unsigned int>(fields.tm_sec), 2);
+            record += ' ';
+            if (!_options.host.empty()) {
+                record += _hostname;
+                record += ' ';
+            }
+            record += _application;
+            record += '[';
+            append_number(record, _pid);
+            record += "]: ";
+            if (append_text_context(record)) {
+                record += ' ';
+            }
+        }
+        record += message;
+    }
+
+    void syslog_client::connect_socket()
+    {
+        int fd = socket(_address.ss_family, SOCK_DGRAM, 0);
+        if (fd < 0) {
+            return;
+        }
+        fcntl(fd, F_SETFD, FD_CLOEXEC);
+        if (connect(fd, reinterpret_cast<sockaddr*>(&_address), _address_size) != 0) {
+            close(fd);
+            _socket = scoped_descriptor();
+            return;
+        }
+        _socket = scoped_descriptor(fd);
+    }
+
+    void syslog_client::send(size_t count)
+    {
+        if (static_cast<int>(_socket) < 0) {
+            connect_socket();
+        }
+
+        bool reconnected = false;
+        size_t done = 0;
+        while (done < count) {
+            if (static_cast<int>(_socket) < 0) {
+                _dropped += count - done;
+                return;
+            }
+
+            size_t batch = min(count - done, _options.batch_size);
+            for (size_t i = 0; i < batch; ++i) {
+                _iov[i].iov_base = const_cast<char*>(_sending[done + i].data());
+                _iov[i].iov_len = _sending[done + i].size();
+            }
+#ifdef HAS_SENDMMSG
+            memset(_messages.data(), 0, batch * sizeof(mmsghdr));
+            for (size_t i = 0; i < batch; ++i) {
+                _messages[i].msg_hdr.msg_iov = &_iov[i];
+                _messages[i].msg_hdr.msg_iovlen = 1;
+            }
+            int result = sendmmsg(_socket, _messages.data(), static_cast<unsigned int>(batch), 0);
+#else
+            int result = 0;
+            for (; static_cast<size_t>(result) < batch; ++result) {
+                if (::send(_socket, _iov[result].iov_base, _iov[result].iov_len, 0) < 0) {
+                    break;
+                }
+            }
+            if (result == 0) {
+                result = -1;
+            }
+#endif
+            if (result > 0) {
+                _sent += result;
+                done += result;
+                continue;
+            }
+            if (errno == EINTR) {
+                continue;
+            }
+            if (!reconnected && (errno == ECONNREFUSED || errno == ENOTCONN || errno == EDESTADDRREQ)) {
+                // The syslog daemon restarted; reconnect once and try again.
+                reconnected = true;
+                connect_socket();
+                continue;
+            }
+            // Skip the message that couldn't be sent (e.g. EMSGSIZE) rather than the whole batch.
+            ++_dropped;
+            ++done;
+        }
+    }
+
+    void syslog_client::run_flusher()
+    {
+        unique_lock<mutex> lock(_mutex);
+        while (!_stopping) {
+            if (_pending_count == 0) {
+                _wakeup.wait(lock);
+            } else if (_pending_count < _options.batch_size) {
+                _wakeup.wait_until(lock, _oldest + _options.flush_interval);
+            }
+            if (_stopping) {
+                break;
+            }
+            if (_pending_count >= _options.batch_size ||
+                (_pending_count > 0 && steady::now() - _oldest >= _options.flush_interval)) {
+                lock.unlock();
+                flush();
+                lock.lock();
+            }
+        }
+    }
+
+    static mutex g_syslog_mutex;
+    static shared_ptr<syslog_client> g_syslog_client;
+
+    void setup_native_syslog_logging(const char* application, const string& facility, syslog_options options)
+    {
+        int fac = static_cast<int>(string_to_syslog_facility(facility));
+        auto client = make_shared<syslog_client>(application, fac, move(options));
+        {
+            lock_guard<mutex> lock(g_syslog_mutex);
+            swap(client, g_syslog_client);
+        }
+        client.reset();
+
+        // Default to the warning level
+        set_level(log_level::warning);
+        enable_syslog();
+    }
+
+    void flush_syslog_logging()
+    {
+        shared_ptr<syslog_client> client;
+        {
+            lock_guard<mutex> lock(g_syslog_mutex);
+            client = g_syslog_client;
+        }
+        if (client) {
+            client->flush();
+        }
+    }
+
+    syslog_stats get_syslog_stats()
+    {
+        lock_guard<mutex> lock(g_syslog_mutex);
+        return g_syslog_client ? g_syslog_client->stats() : syslog_stats { 0, 0 };
+    }
+
+    void clean_native_syslog()
+    {
+        shared_ptr<syslog_client> client;
+        {
+            lock_guard<mutex> lock(g_syslog_mutex);
+            swap(client, g_syslog_client);
+        }
+    }
+
+    bool log_native_syslog(log_level level, string const& message)
+    {
+        shared_ptr<syslog_client> client;
+        {
+            lock_guard<mutex> lock(g_syslog_mutex);
+            client = g_syslog_client;
+        }
+        if (!client) {
+            return false;
+        }
+        client->log(level, message);
+        return true;
+    }
+
+}}  // namespace leatherman::logging
@@ -0,0 +1,23 @@
+#include <leatherman/logging/logging.hpp>
+#include <string>
+
+namespace leatherman { namespace logging {
+
+    syslog_facility string_to_syslog_facility(std::string facility);
+
+    int log_level_to_severity(log_level level);
+
+    /**
+     * Queues a message with the native syslog client.
+     * @param level The logging level of the message.
+     * @param message The message to log.
+     * @return Returns false if the native client isn't set up and libc's syslog() should be used instead.
+     */
+    bool log_native_syslog(log_level level, std::string const& message);
+
+    /**
+     * Flushes and stops the native syslog client, if one is set up.
+     */
+    void clean_native_syslog();
+
+}}  // namespace leatherman::logging
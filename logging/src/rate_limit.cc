@@ -0,0 +1,112 @@
+#include <leatherman/logging/logging.hpp>
+#include <leatherman/locale/locale.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include "record.hpp"
+
+using namespace std;
+
+namespace leatherman { namespace logging {
+
+    // The limits are read on every logging macro call, so they're kept as separate atomics rather than
+    // behind a lock; a message racing with reconfiguration may see a mix of old and new limits.
+    static atomic<bool> g_limiting{false};
+    static atomic<int64_t> g_rate_interval{0};
+    static atomic<int64_t> g_rate_tolerance{0};
+    static atomic<bool> g_suppress_duplicates{false};
+    static atomic<int64_t> g_duplicate_interval{0};
+
+    static int64_t now_nanoseconds()
+    {
+        return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    void set_rate_limit(rate_limit_options options)
+    {
+        int64_t interval = 0;
+        if (options.messages_per_second > 0) {
+            interval = static_cast<int64_t>(1000000000.0 / options.messages_per_second);
+        }
+        g_rate_interval = interval;
+        g_rate_tolerance = interval * (max(options.burst, 1u) - 1);
+        g_suppress_duplicates = options.suppress_duplicates;
+        g_duplicate_interval = chrono::duration_cast<chrono::nanoseconds>(options.duplicate_interval).count();
+        g_limiting = interval > 0 || options.suppress_duplicates;
+    }
+
+    void disable_rate_limit()
+    {
+        g_limiting = false;
+    }
+
+    bool admit_message(call_site& site, log_level level)
+    {
+        // Messages that are only being recorded by the flight recorder aren't limited.
+        if (!g_limiting.load(memory_order_relaxed) || !is_enabled(level)) {
+            return true;
+        }
+        auto interval = g_rate_interval.load(memory_order_relaxed);
+        if (interval == 0) {
+            return true;
+        }
+
+        // Generic cell rate algorithm: each message pushes the site's theoretical arrival time out by one
+        // interval, and a message is admitted as long as that time is no more than a burst ahead of now.
+        auto now = now_nanoseconds();
+        auto tolerance = g_rate_tolerance.load(memory_order_relaxed);
+        auto next = site.next.load(memory_order_relaxed);
+        do {
+            if (next - tolerance > now) {
+                ++site.suppressed;
+                if (level >= log_level::error) {
+                    set_error_logged();
+                }
+                return false;
+            }
+        } while (!site.next.compare_exchange_weak(next, max(next, now) + interval, memory_order_relaxed));
+        return true;
+    }
+
+    void log_call_site(call_site& site, string const& logger, log_level level, int line_num, string const& message)
+    {
+        if (!g_limiting.load(memory_order_relaxed) || !is_enabled(level)) {
+            log_helper(logger, level, line_num, message);
+            return;
+        }
+
+        if (g_suppress_duplicates.load(memory_order_relaxed)) {
+            auto now = now_nanoseconds();
+            auto hash = std::hash<string>()(message);
+            if (site.last_hash.exchange(hash) == hash) {
+                ++site.repeats;
+                if (now - site.summarized.load(memory_order_relaxed) < g_duplicate_interval.load(memory_order_relaxed)) {
+                    if (level >= log_level::error) {
+                        set_error_logged();
+                    }
+                    return;
+                }
+                site.summarized = now;
+                auto repeats = static_cast<int>(site.repeats.exchange(0));
+                log_helper(logger, level, line_num,
+                    leatherman::locale::format_n("last message repeated {1} time", "last message repeated {1} times", repeats, repeats));
+                return;
+            }
+            site.summarized = now;
+            auto repeats = static_cast<int>(site.repeats.exchange(0));
+            if (repeats > 0) {
+                log_helper(logger, level, line_num,
+                    leatherman::locale::format_n("last message repeated {1} time", "last message repeated {1} times", repeats, repeats));
+            }
+        }
+
+        auto suppressed = static_cast<int>(site.suppressed.exchange(0));
+        if (suppressed > 0) {
+            log_helper(logger, level, line_num,
+                leatherman::locale::format_n("{1} message suppressed by rate limiting", "{1} messages suppressed by rate limiting", suppressed, suppressed));
+        }
+        log_helper(logger, level, line_num, message);
+    }
+
+}}  // namespace leatherman::logging
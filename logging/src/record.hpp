@@ -0,0 +1,130 @@
+#include <leatherman/logging/logging.hpp>
+#include <boost/utility/string_ref.hpp>
+#include <string>
+
+namespace leatherman { namespace logging {
+
+    /**
+     * Gets the printed representation of a logging level without going through an ostream.
+     * @param level The logging level.
+     * @return Returns the level name, or an empty string for log_level::none.
+     */
+    char const* level_name(log_level level);
+
+    /**
+     * Appends a decimal number to a buffer without going through an ostream.
+     * @param buffer The buffer to append to.
+     * @param value The number to append.
+     * @param width The minimum number of digits to append, padding with leading zeros.
+     */
+    void append_number(std::string& buffer, unsigned int value, size_t width = 0);
+
+    /**
+     * Appends the current local time, formatted as "YYYY-MM-DD HH:MM:SS.ffffff", to a buffer.
+     * @param buffer The buffer to append to.
+     * @param separator The character between the date and the time.
+     */
+    void append_timestamp(std::string& buffer, char separator = ' ');
+
+    /**
+     * Gets an identifier for the calling thread, as shown by the operating system's tools where possible.
+     * @return Returns the thread identifier.
+     */
+    uint64_t current_thread_id();
+
+    /**
+     * Appends a string to a buffer as a quoted JSON string.
+     * @param buffer The buffer to append to.
+     * @param value The UTF-8 string to escape.
+     */
+    void append_json_string(std::string& buffer, boost::string_ref value);
+
+    /**
+     * Renders additional JSON fields once, so they can be appended to every record without re-escaping.
+     * @param fields The fields to render.
+     * @return Returns the fields as a fragment to pass to append_json_record.
+     */
+    std::string render_json_fields(json_log_fields const& fields);
+
+    /**
+     * Appends a plain-text log record terminated by a newline to a buffer.
+     * The layout matches the stream backend's, without colorization.
+     * @param buffer The buffer to append to.
+     * @param logger The logger the message was logged to.
+     * @param level The logging level of the message.
+     * @param line_num The source line number of the logging call, or 0 if not known.
+     * @param message The message to log.
+     */
+    void append_text_record(std::string& buffer, std::string const& logger, log_level level, int line_num, std::string const& message);
+
+    /**
+     * Appends the calling thread's logging context to a buffer as "[key=value key=value]".
+     * @param buffer The buffer to append to.
+     * @return Returns true if there was any context to append, or false if nothing was appended.
+     */
+    bool append_text_context(std::string& buffer);
+
+    /**
+     * Appends the calling thread's logging context to a buffer as a "context" member of a JSON object,
+     * preceded by a comma. Nothing is appended if there is no context.
+     * @param buffer The buffer to append to.
+     */
+    void append_json_context(std::string& buffer);
+
+    /**
+     * Appends the calling thread's logging context to a buffer as an RFC 5424 structured data element,
+     * or the nil value "-" if there is no context.
+     * @param buffer The buffer to append to.
+     * @param id The SD-ID of the element.
+     */
+    void append_structured_data(std::string& buffer, std::string const& id);
+
+    /**
+     * Appends a log record as a JSON object terminated by a newline to a buffer.
+     * @param buffer The buffer to append to.
+     * @param logger The logger the message was logged to.
+     * @param level The logging level of the message.
+     * @param line_num The source line number of the logging call, or 0 if not known.
+     * @param message The message to log.
+     * @param fields Additional fields, as rendered by render_json_fields.
+     */
+    void append_json_record(std::string& buffer, std::string const& logger, log_level level, int line_num,
+                            std::string const& message, std::string const& fields);
+
+    /**
+     * Records a message that is below the current log level in the calling thread's flight recorder buffer.
+     * @param logger The logger the message was logged to.
+     * @param level The logging level of the message.
+     * @param line_num The source line number of the logging call, or 0 if not known.
+     * @param message The message to record.
+     */
+    void record_message(std::string const& logger, log_level level, int line_num, std::string const& message);
+
+    /**
+     * Dumps the flight recorder if it's enabled and configured to dump when errors are logged.
+     */
+    void dump_flight_recorder_on_error();
+
+    /**
+     * Writes a recorded message to the current logging backend, bypassing the level check and subscribers.
+     * @param logger The logger the message was logged to.
+     * @param level The logging level of the message.
+     * @param line_num The source line number of the logging call, or 0 if not known.
+     * @param message The message to write.
+     */
+    void log_recorded(std::string const& logger, log_level level, int line_num, std::string const& message);
+
+    /**
+     * Passes a message to each subscriber that asked for its level.
+     * @param level The logging level of the message.
+     * @param message The message.
+     * @return Returns false if any subscriber asked for the message not to be logged, or true otherwise.
+     */
+    bool notify_subscribers(log_level level, std::string const& message);
+
+    /**
+     * Flags that an error has been logged, for messages that are dropped before reaching log_helper.
+     */
+    void set_error_logged();
+
+}}  // namespace leatherman::logging
@@ -0,0 +1,158 @@
+#include <leatherman/logging/logging.hpp>
+#include <leatherman/locale/locale.hpp>
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+#include "record.hpp"
+
+// Mark string for translation (alias for leatherman::locale::format)
+using leatherman::locale::_;
+
+using namespace std;
+
+namespace leatherman { namespace logging {
+
+    struct subscriber
+    {
+        subscriber_token token;
+        log_level_mask levels;
+        function<bool(log_level, string const&)> callback;
+    };
+
+    /**
+     * An immutable list of subscribers. Changing the subscribers publishes a new snapshot; the old one
+     * is retired and freed once no thread can still be reading it.
+     */
+    struct subscriber_snapshot
+    {
+        vector<subscriber> subscribers;
+        log_level_mask levels = 0;
+    };
+
+    // Readers count themselves in g_readers before loading g_snapshot and out again when done, so a writer
+    // that sees no readers after publishing a new snapshot knows nothing still refers to retired ones.
+    // A single counter may never drop to zero under constant logging, in which case retired snapshots
+    // wait for a quieter moment; they're only created when subscribers change, which is rare.
+    static atomic<subscriber_snapshot*> g_snapshot{nullptr};
+    static atomic<unsigned int> g_readers{0};
+
+    // Guards changes to the subscribers: the retired snapshots, the next token and the legacy on_message slot.
+    static mutex g_subscriber_mutex;
+    static vector<unique_ptr<subscriber_snapshot>> g_retired;
+    static subscriber_token g_next_token = 1;
+    static subscriber_token g_on_message_token = 0;
+
+    struct reader_guard
+    {
+        reader_guard() { ++g_readers; }
+        ~reader_guard() { --g_readers; }
+    };
+
+    // Must be called with g_subscriber_mutex held.
+    static void publish(unique_ptr<subscriber_snapshot> snapshot)
+    {
+        if (snapshot && snapshot->subscribers.empty()) {
+            snapshot.reset();
+        }
+        if (snapshot) {
+            for (auto const& s : snapshot->subscribers) {
+                snapshot->levels |= s.levels;
+            }
+        }
+        unique_ptr<subscriber_snapshot> previous(g_snapshot.exchange(snapshot.release()));
+        if (previous) {
+            g_retired.push_back(move(previous));
+        }
+        if (g_readers == 0) {
+            g_retired.clear();
+        }
+    }
+
+    // Must be called with g_subscriber_mutex held.
+    static unique_ptr<subscriber_snapshot> copy_snapshot()
+    {
+        unique_ptr<subscriber_snapshot> snapshot(new subscriber_snapshot());
+        // Only writers replace the snapshot and they hold the mutex, so it can't be retired while copying.
+        auto current = g_snapshot.load();
+        if (current) {
+            snapshot->subscribers = current->subscribers;
+        }
+        return snapshot;
+    }
+
+    // Must be called with g_subscriber_mutex held.
+    static subscriber_token add_locked(function<bool(log_level, string const&)> callback, log_level_mask levels)
+    {
+        auto snapshot = copy_snapshot();
+        auto token = g_next_token++;
+        snapshot->subscribers.push_back(subscriber{ token, levels, move(callback) });
+        publish(move(snapshot));
+        return token;
+    }
+
+    // Must be called with g_subscriber_mutex held.
+    static void remove_locked(subscriber_token token)
+    {
+        auto snapshot = copy_snapshot();
+        auto& subscribers = snapshot->subscribers;
+        auto it = find_if(subscribers.begin(), subscribers.end(), [&](subscriber const& s) { return s.token == token; });
+        if (it == subscribers.end()) {
+            return;
+        }
+        subscribers.erase(it);
+        publish(move(snapshot));
+    }
+
+    subscriber_token add_subscriber(function<bool(log_level, string const&)> callback, log_level_mask levels)
+    {
+        if (!callback) {
+            throw invalid_argument(_("subscriber callback cannot be empty."));
+        }
+        lock_guard<mutex> lock(g_subscriber_mutex);
+        return add_locked(move(callback), levels);
+    }
+
+    void remove_subscriber(subscriber_token token)
+    {
+        lock_guard<mutex> lock(g_subscriber_mutex);
+        remove_locked(token);
+    }
+
+    // cppcheck-suppress passedByValue
+    void on_message(function<bool(log_level, string const&)> callback)
+    {
+        lock_guard<mutex> lock(g_subscriber_mutex);
+        if (g_on_message_token != 0) {
+            remove_locked(g_on_message_token);
+            g_on_message_token = 0;
+        }
+        if (callback) {
+            g_on_message_token = add_locked(move(callback), all_levels);
+        }
+    }
+
+    bool notify_subscribers(log_level level, string const& message)
+    {
+        // Checked without counting as a reader; the snapshot isn't dereferenced here.
+        if (!g_snapshot.load(memory_order_acquire)) {
+            return true;
+        }
+
+        reader_guard guard;
+        auto snapshot = g_snapshot.load();
+        if (!snapshot || !(snapshot->levels & level_mask(level))) {
+            return true;
+        }
+        bool log = true;
+        for (auto const& s : snapshot->subscribers) {
+            if ((s.levels & level_mask(level)) && !s.callback(level, message)) {
+                log = false;
+            }
+        }
+        return log;
+    }
+
+}}  // namespace leatherman::logging
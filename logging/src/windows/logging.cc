@@ -1,6 +1,7 @@
 #include <leatherman/logging/logging.hpp>
 #include <boost/nowide/iostream.hpp>
 #include <windows.h>
+#include "../record.hpp"
 
 #define STATUS_SEVERITY_SUCCESS          0x0
 #define STATUS_SEVERITY_ERROR            0x1
@@ -59,6 +60,11 @@ namespace leatherman { namespace logging {
         return colorize;
     }
 
+    uint64_t current_thread_id()
+    {
+        return GetCurrentThreadId();
+    }
+
     void setup_eventlog_logging(string application)
     {
         const wstring w_application(application.begin(), application.end());
@@ -116,6 +122,28 @@ namespace leatherman { namespace logging {
         throw runtime_error("syslog is only available on POSIX platforms");
     }
 
+    void setup_file_logging(string const& path, file_logging_options options)
+    {
+        throw runtime_error("file logging is only available on POSIX platforms");
+    }
+
+    void flush_file_logging()
+    {
+    }
+
+    void reopen_file_logging()
+    {
+    }
+
+    void clean_file_logging()
+    {
+    }
+
+    void log_file(string const& logger, log_level level, int line_num, string const& message)
+    {
+        throw runtime_error("file logging is only available on POSIX platforms");
+    }
+
     void clean_eventlog_logging()
     {
         if (h_event_log) {
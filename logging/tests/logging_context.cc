@@ -0,0 +1,88 @@
+#include <catch.hpp>
+#include <boost/nowide/iostream.hpp>
+#include <memory>
+#include <sstream>
+#include <thread>
+#include "logging.hpp"
+
+using namespace std;
+using namespace leatherman::logging;
+
+using context_pairs = vector<pair<string, string>>;
+
+SCENARIO("adding to the logging context") {
+    REQUIRE(get_log_context().empty());
+
+    GIVEN("nested scopes") {
+        scoped_log_context request("request_id", "abc");
+        {
+            scoped_log_context probe("probe", "disk");
+            THEN("the context has both pairs in order") {
+                REQUIRE(get_log_context() == (context_pairs{ { "request_id", "abc" }, { "probe", "disk" } }));
+            }
+        }
+        THEN("the inner pair is removed when its scope ends") {
+            REQUIRE(get_log_context() == (context_pairs{ { "request_id", "abc" } }));
+        }
+    }
+
+    GIVEN("a value too long for the buffer") {
+        scoped_log_context big("big", string(1000, 'x'));
+        scoped_log_context after("after", "value");
+        THEN("the value is truncated and later pairs are left out") {
+            auto context = get_log_context();
+            REQUIRE(context.size() == 1u);
+            REQUIRE(context[0].first == "big");
+            REQUIRE(context[0].second.size() < 1000u);
+        }
+    }
+
+    GIVEN("more pairs than fit") {
+        vector<unique_ptr<scoped_log_context>> scopes;
+        for (int i = 0; i < 20; ++i) {
+            scopes.emplace_back(new scoped_log_context("key", to_string(i)));
+        }
+        THEN("the extra pairs are left out") {
+            REQUIRE(get_log_context().size() == 16u);
+        }
+
+        // Scopes have to end in the reverse of the order they were created in.
+        while (!scopes.empty()) {
+            scopes.pop_back();
+        }
+    }
+
+    GIVEN("another thread") {
+        scoped_log_context request("request_id", "abc");
+        context_pairs other;
+        thread([&]() { other = get_log_context(); }).join();
+        THEN("the context isn't shared") {
+            REQUIRE(other.empty());
+        }
+    }
+
+    REQUIRE(get_log_context().empty());
+}
+
+SCENARIO("logging with a logging context as JSON") {
+    leatherman::test::logging_context context(log_level::trace);
+    ostringstream stream;
+    setup_json_logging(stream);
+    set_level(log_level::trace);
+
+    WHEN("a message is logged in a context") {
+        scoped_log_context request("request_id", "a\"b");
+        LOG_INFO("in context");
+        THEN("the context is an object following the message") {
+            REQUIRE(stream.str().find("\"message\":\"in context\",\"context\":{\"request_id\":\"a\\\"b\"}}\n") != string::npos);
+        }
+    }
+    WHEN("a message is logged without a context") {
+        LOG_INFO("no context");
+        THEN("there is no context member") {
+            REQUIRE(stream.str().find("\"context\"") == string::npos);
+        }
+    }
+
+    setup_logging(boost::nowide::cout);
+}
@@ -0,0 +1,145 @@
+#include <catch.hpp>
+#include <boost/nowide/iostream.hpp>
+#include <sstream>
+#include <thread>
+#include "logging.hpp"
+
+using namespace std;
+using namespace leatherman::logging;
+
+namespace leatherman { namespace test {
+
+    /**
+     * Records below the warning level and captures output with the json backend, which is easy to search.
+     */
+    struct flight_recorder_context : logging_context
+    {
+        explicit flight_recorder_context(flight_recorder_options options = flight_recorder_options()) :
+            logging_context(log_level::warning)
+        {
+            setup_json_logging(stream);
+            enable_flight_recorder(move(options));
+        }
+
+        ~flight_recorder_context()
+        {
+            disable_flight_recorder();
+            setup_logging(boost::nowide::cout);
+        }
+
+        ostringstream stream;
+    };
+
+}}  // namespace leatherman::test
+
+using namespace leatherman::test;
+
+SCENARIO("recording messages below the log level") {
+    GIVEN("the default options") {
+        flight_recorder_context context;
+        REQUIRE(is_recording(log_level::trace));
+        REQUIRE_FALSE(LOG_IS_DEBUG_ENABLED());
+
+        WHEN("debug and info messages are logged") {
+            LOG_DEBUG("debug {1}", 1);
+            LOG_INFO("info {1}", 2);
+            THEN("nothing is written") {
+                REQUIRE(context.stream.str().empty());
+            }
+            AND_WHEN("an error is logged") {
+                LOG_ERROR("failed");
+                THEN("the recorded messages are written before it") {
+                    auto output = context.stream.str();
+                    auto debug = output.find("\"level\":\"DEBUG\"");
+                    auto info = output.find("\"level\":\"INFO\"");
+                    auto error = output.find("\"message\":\"failed\"");
+                    REQUIRE(debug != string::npos);
+                    REQUIRE(info != string::npos);
+                    REQUIRE(error != string::npos);
+                    REQUIRE(debug < info);
+                    REQUIRE(info < error);
+                    REQUIRE(boost::regex_search(output, boost::regex(
+                        "\"message\":\"\\[recorded at \\d{2}:\\d{2}:\\d{2}\\.\\d{6}\\] debug 1\"")));
+                }
+                THEN("they aren't written again by the next error") {
+                    LOG_ERROR("failed again");
+                    auto output = context.stream.str();
+                    REQUIRE(count(output.begin(), output.end(), '\n') == 4);
+                }
+            }
+        }
+        WHEN("messages are logged on another thread") {
+            thread([]() { LOG_TRACE("from another thread"); }).join();
+            THEN("they are dumped on demand") {
+                dump_flight_recorder();
+                REQUIRE(context.stream.str().find("from another thread") != string::npos);
+            }
+        }
+        WHEN("a message is logged directly") {
+            log("test", log_level::debug, 12, "direct");
+            dump_flight_recorder();
+            THEN("its namespace and line number are kept") {
+                REQUIRE(context.stream.str().find("\"namespace\":\"test\",\"line\":12,") != string::npos);
+            }
+        }
+    }
+
+    GIVEN("a small capacity and message size") {
+        flight_recorder_options options;
+        options.capacity = 2;
+        options.message_size = 32;
+        flight_recorder_context context(options);
+
+        WHEN("more messages are recorded than fit") {
+            LOG_DEBUG("first");
+            LOG_DEBUG("second");
+            LOG_DEBUG("third");
+            LOG_DEBUG("a message that is much too long to keep in full");
+            dump_flight_recorder();
+            THEN("only the most recent are kept, truncated") {
+                auto output = context.stream.str();
+                REQUIRE(output.find("second") == string::npos);
+                REQUIRE(output.find("third") != string::npos);
+                REQUIRE(output.find("a message that is much too long to keep in full") == string::npos);
+                REQUIRE(output.find("a message") != string::npos);
+            }
+        }
+    }
+
+    GIVEN("recording from the info level without dumping on error") {
+        flight_recorder_options options;
+        options.level = log_level::info;
+        options.dump_on_error = false;
+        flight_recorder_context context(options);
+        REQUIRE_FALSE(is_recording(log_level::debug));
+
+        WHEN("an error is logged") {
+            LOG_DEBUG("not recorded");
+            LOG_INFO("recorded");
+            LOG_ERROR("failed");
+            THEN("only the error is written") {
+                REQUIRE(context.stream.str().find("recorded") == string::npos);
+            }
+            THEN("the recorded messages can still be dumped") {
+                dump_flight_recorder();
+                auto output = context.stream.str();
+                REQUIRE(output.find("not recorded") == string::npos);
+                REQUIRE(output.find("recorded") != string::npos);
+            }
+        }
+    }
+
+    GIVEN("the flight recorder is disabled") {
+        flight_recorder_context context;
+        disable_flight_recorder();
+        REQUIRE_FALSE(is_recording(log_level::trace));
+
+        WHEN("an error is logged") {
+            LOG_DEBUG("debug");
+            LOG_ERROR("failed");
+            THEN("nothing was recorded") {
+                REQUIRE(context.stream.str().find("debug") == string::npos);
+            }
+        }
+    }
+}
@@ -98,6 +98,11 @@ TEST_CASE("logging i18n with on_message") {
         REQUIRE(level == log_level::info);
         REQUIRE(message == utf8_reverse);
     }
+    SECTION("a raw message to log is not translated") {
+        LOG_RAW_DEBUG("debug logging");
+        REQUIRE(level == log_level::debug);
+        REQUIRE(message == "debug logging");
+    }
 
     leatherman::locale::clear_domain();
 }
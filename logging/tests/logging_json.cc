@@ -0,0 +1,79 @@
+#include <catch.hpp>
+#include <boost/nowide/iostream.hpp>
+#include <sstream>
+#include "logging.hpp"
+
+using namespace std;
+using namespace leatherman::logging;
+
+namespace leatherman { namespace test {
+
+    struct json_logging_context : logging_context
+    {
+        explicit json_logging_context(json_log_fields fields = json_log_fields()) :
+            logging_context(log_level::trace)
+        {
+            setup_json_logging(stream, move(fields));
+            set_level(log_level::trace);
+        }
+
+        ~json_logging_context()
+        {
+            setup_logging(boost::nowide::cout);
+        }
+
+        ostringstream stream;
+    };
+
+}}  // namespace leatherman::test
+
+using namespace leatherman::test;
+
+SCENARIO("logging as JSON") {
+    GIVEN("no additional fields") {
+        json_logging_context context;
+
+        WHEN("a message is logged with a macro") {
+            LOG_INFO("testing {1} {2} {3}", 1, "2", 3.0);
+            THEN("it is written as a single JSON object") {
+                REQUIRE(boost::regex_match(context.stream.str(), boost::regex(
+                    "\\{\"timestamp\":\"\\d{4}-\\d{2}-\\d{2}T\\d{2}:\\d{2}:\\d{2}\\.\\d{6}\",\"level\":\"INFO\","
+                    "\"namespace\":\"" LOG_NAMESPACE "\",\"thread\":\\d+,\"message\":\"testing 1 2 3\"\\}\n")));
+            }
+        }
+        WHEN("a message is logged with a line number") {
+            log("test", log_level::error, 42, "with a line");
+            THEN("the line number is included") {
+                REQUIRE(context.stream.str().find("\"level\":\"ERROR\",\"namespace\":\"test\",\"line\":42,") != string::npos);
+            }
+        }
+        WHEN("a message contains characters that must be escaped") {
+            LOG_WARNING("quote \" backslash \\ newline \n tab \t bell \a");
+            THEN("they are escaped") {
+                REQUIRE(context.stream.str().find(
+                    "\"message\":\"quote \\\" backslash \\\\ newline \\n tab \\t bell \\u0007\"}\n") != string::npos);
+            }
+        }
+        WHEN("several messages are logged") {
+            LOG_DEBUG("first");
+            LOG_DEBUG("second");
+            THEN("each is on its own line") {
+                auto output = context.stream.str();
+                REQUIRE(count(output.begin(), output.end(), '\n') == 2);
+                REQUIRE(output.find("\"message\":\"first\"}\n{") != string::npos);
+            }
+        }
+    }
+
+    GIVEN("additional fields") {
+        json_logging_context context({ { "service", "agent" }, { "run\"id", "1\n2" } });
+
+        WHEN("a message is logged") {
+            LOG_INFO("with context");
+            THEN("the fields follow the message") {
+                REQUIRE(context.stream.str().find(
+                    "\"message\":\"with context\",\"service\":\"agent\",\"run\\\"id\":\"1\\n2\"}\n") != string::npos);
+            }
+        }
+    }
+}
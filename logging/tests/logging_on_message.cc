@@ -47,6 +47,16 @@ TEST_CASE("logging with on_message") {
         REQUIRE(level == log_level::fatal);
         REQUIRE(message == "fatal message");
     }
+    SECTION("a raw message is logged to on_message as-is") {
+        LOG_RAW_DEBUG("raw {1} message");
+        REQUIRE(level == log_level::debug);
+        REQUIRE(message == "raw {1} message");
+    }
+    SECTION("a raw message logged directly is logged to on_message as-is") {
+        log_raw("test", log_level::info, 0, "raw {1} message");
+        REQUIRE(level == log_level::info);
+        REQUIRE(message == "raw {1} message");
+    }
 #if 0
     SECTION("a unicode characters to log") {
         const wstring symbols[] = {L"\u2122", L"\u2744", L"\u039b"};
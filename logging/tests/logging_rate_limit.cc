@@ -0,0 +1,104 @@
+#include <catch.hpp>
+#include <leatherman/logging/logging.hpp>
+#include <thread>
+#include "logging.hpp"
+
+using namespace std;
+using namespace leatherman::logging;
+
+TEST_CASE("logging with a rate limit") {
+    leatherman::test::logging_context ctx(log_level::trace);
+
+    vector<string> messages;
+    on_message([&](log_level, string const& msg) {
+        messages.push_back(msg);
+        return false;
+    });
+
+    SECTION("messages aren't limited by default") {
+        for (int i = 0; i < 50; ++i) {
+            LOG_DEBUG("message {1}", i);
+        }
+        REQUIRE(messages.size() == 50u);
+    }
+
+    // Call sites keep their state for the life of the process, so each section uses its own.
+    SECTION("messages over the rate are dropped and counted") {
+        rate_limit_options options;
+        options.messages_per_second = 20;
+        options.burst = 3;
+        options.suppress_duplicates = false;
+        set_rate_limit(options);
+
+        for (int i = 0; i < 11; ++i) {
+            if (i == 10) {
+                this_thread::sleep_for(chrono::milliseconds(60));
+            }
+            LOG_WARNING("message {1}", i);
+            if (i == 9) {
+                REQUIRE(messages.size() == 3u);
+                REQUIRE(messages.back() == "message 2");
+
+                // A different call site isn't limited.
+                LOG_WARNING("another site");
+                REQUIRE(messages.size() == 4u);
+            }
+        }
+        REQUIRE(messages.size() == 6u);
+        REQUIRE(messages[4] == "7 messages suppressed by rate limiting");
+        REQUIRE(messages[5] == "message 10");
+    }
+
+    SECTION("a dropped error is still flagged") {
+        rate_limit_options options;
+        options.burst = 1;
+        set_rate_limit(options);
+
+        for (int i = 0; i < 2; ++i) {
+            clear_error_logged_flag();
+            LOG_ERROR("error {1}", i);
+            REQUIRE(error_has_been_logged());
+        }
+        REQUIRE(messages.size() == 1u);
+    }
+
+    SECTION("repeated messages are collapsed") {
+        rate_limit_options options;
+        options.messages_per_second = 0;
+        set_rate_limit(options);
+
+        for (int i = 0; i < 6; ++i) {
+            LOG_INFO("the same thing {1}", i < 5 ? "again" : "changed");
+        }
+        REQUIRE(messages.size() == 3u);
+        REQUIRE(messages[0] == "the same thing again");
+        REQUIRE(messages[1] == "last message repeated 4 times");
+        REQUIRE(messages[2] == "the same thing changed");
+    }
+
+    SECTION("repeated messages are summarized after the duplicate interval") {
+        rate_limit_options options;
+        options.messages_per_second = 0;
+        options.duplicate_interval = chrono::milliseconds(50);
+        set_rate_limit(options);
+
+        for (int i = 0; i < 3; ++i) {
+            if (i == 2) {
+                this_thread::sleep_for(chrono::milliseconds(60));
+            }
+            LOG_INFO("repeated");
+        }
+        REQUIRE(messages.size() == 2u);
+        REQUIRE(messages[1] == "last message repeated 2 times");
+    }
+
+    SECTION("messages logged directly aren't limited") {
+        set_rate_limit();
+        for (int i = 0; i < 50; ++i) {
+            log("test", log_level::info, 0, "direct");
+        }
+        REQUIRE(messages.size() == 50u);
+    }
+
+    disable_rate_limit();
+}
@@ -0,0 +1,101 @@
+#include <catch.hpp>
+#include <leatherman/logging/logging.hpp>
+#include <atomic>
+#include <thread>
+#include "logging.hpp"
+
+using namespace std;
+using namespace leatherman::logging;
+
+TEST_CASE("logging with subscribers") {
+    leatherman::test::logging_context ctx(log_level::trace);
+
+    vector<string> counted;
+    vector<string> forwarded;
+    auto counter = add_subscriber([&](log_level, string const& msg) {
+        counted.push_back(msg);
+        return false;
+    });
+    auto forwarder = add_subscriber([&](log_level, string const& msg) {
+        forwarded.push_back(msg);
+        return false;
+    }, levels_at_or_above(log_level::warning));
+
+    SECTION("each subscriber sees the levels it asked for") {
+        LOG_DEBUG("debug message");
+        LOG_ERROR("error message");
+        REQUIRE(counted == (vector<string>{ "debug message", "error message" }));
+        REQUIRE(forwarded == vector<string>{ "error message" });
+    }
+    SECTION("a removed subscriber isn't called") {
+        remove_subscriber(counter);
+        LOG_WARNING("warning message");
+        REQUIRE(counted.empty());
+        REQUIRE(forwarded == vector<string>{ "warning message" });
+    }
+    SECTION("subscribers are kept alongside the on_message callback") {
+        string message;
+        on_message([&](log_level, string const& msg) {
+            message = msg;
+            return false;
+        });
+        LOG_INFO("info message");
+        REQUIRE(message == "info message");
+        REQUIRE(counted == vector<string>{ "info message" });
+
+        on_message(nullptr);
+        LOG_INFO("another message");
+        REQUIRE(message == "info message");
+        REQUIRE(counted.size() == 2u);
+    }
+    SECTION("a subscriber can remove itself") {
+        subscriber_token self = 0;
+        int calls = 0;
+        self = add_subscriber([&](log_level, string const&) {
+            ++calls;
+            remove_subscriber(self);
+            return false;
+        }, level_mask(log_level::info));
+        LOG_INFO("first");
+        LOG_INFO("second");
+        REQUIRE(calls == 1);
+        REQUIRE(counted.size() == 2u);
+    }
+    SECTION("subscribers can change while other threads log") {
+        atomic<bool> done{false};
+        atomic<int> calls{0};
+        remove_subscriber(counter);
+        remove_subscriber(forwarder);
+        auto suppressor = add_subscriber([&](log_level, string const&) {
+            ++calls;
+            return false;
+        });
+        vector<thread> loggers;
+        for (int i = 0; i < 4; ++i) {
+            loggers.emplace_back([&]() {
+                while (!done) {
+                    log_helper("test", log_level::trace, 0, "from another thread");
+                }
+            });
+        }
+        for (int i = 0; i < 100; ++i) {
+            auto token = add_subscriber([&](log_level, string const&) {
+                return false;
+            });
+            this_thread::yield();
+            remove_subscriber(token);
+        }
+        done = true;
+        for (auto& t : loggers) {
+            t.join();
+        }
+        remove_subscriber(suppressor);
+        REQUIRE(calls > 0);
+    }
+    SECTION("an empty callback is rejected") {
+        REQUIRE_THROWS_AS(add_subscriber(nullptr), invalid_argument);
+    }
+
+    remove_subscriber(counter);
+    remove_subscriber(forwarder);
+}
@@ -0,0 +1,198 @@
+#include <catch.hpp>
+#include <leatherman/logging/logging.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/nowide/fstream.hpp>
+#include <atomic>
+#include <csignal>
+#include <iterator>
+#include "../logging.hpp"
+
+using namespace std;
+using namespace leatherman::logging;
+namespace fs = boost::filesystem;
+
+namespace leatherman { namespace test {
+
+    struct file_logging_context : logging_context
+    {
+        explicit file_logging_context(file_logging_options options = file_logging_options()) :
+            logging_context(log_level::trace),
+            dir(fs::temp_directory_path() / fs::unique_path("lth_file_logging_%%%%-%%%%")),
+            path((dir / "test.log").string())
+        {
+            fs::create_directories(dir);
+            setup_file_logging(path, move(options));
+            set_level(log_level::trace);
+        }
+
+        ~file_logging_context()
+        {
+            clean_file_logging();
+            fs::remove_all(dir);
+        }
+
+        string contents(string const& file = {}) const
+        {
+            boost::nowide::ifstream in((file.empty() ? path : file).c_str());
+            return string(istreambuf_iterator<char>(in), istreambuf_iterator<char>());
+        }
+
+        fs::path dir;
+        string path;
+    };
+
+}}  // namespace leatherman::test
+
+using namespace leatherman::test;
+
+SCENARIO("logging to a file") {
+    GIVEN("the default options") {
+        file_logging_context context;
+
+        WHEN("an info message is logged") {
+            LOG_INFO("testing {1} {2} {3}", 1, "2", 3.0);
+            THEN("it is buffered until flushed") {
+                REQUIRE(context.contents().empty());
+                flush_file_logging();
+                auto contents = context.contents();
+                REQUIRE(boost::regex_match(contents, boost::regex(
+                    "\\d{4}-\\d{2}-\\d{2} [0-2]\\d:[0-5]\\d:\\d{2}\\.\\d{6} INFO  " LOG_NAMESPACE " - testing 1 2 3\n")));
+            }
+            THEN("it is written when the file logger is cleaned up") {
+                clean_file_logging();
+                REQUIRE(context.contents().find("testing 1 2 3") != string::npos);
+            }
+        }
+        WHEN("a warning is logged") {
+            LOG_INFO("first");
+            LOG_WARNING("second");
+            THEN("it is written immediately along with earlier messages") {
+                auto contents = context.contents();
+                REQUIRE(contents.find("INFO  " LOG_NAMESPACE " - first\n") != string::npos);
+                REQUIRE(contents.find("WARN  " LOG_NAMESPACE " - second\n") != string::npos);
+            }
+        }
+        WHEN("a message is logged in a logging context") {
+            scoped_log_context request("request_id", "abc");
+            scoped_log_context probe("probe", "disk");
+            log("test", log_level::error, 0, "in context");
+            THEN("the context follows the namespace") {
+                REQUIRE(context.contents().find("ERROR test [request_id=abc probe=disk] - in context\n") != string::npos);
+            }
+        }
+        WHEN("a message is logged directly with a line number") {
+            log("test", log_level::error, 42, "with a line");
+            THEN("the line number follows the namespace") {
+                REQUIRE(context.contents().find("ERROR test:42 - with a line\n") != string::npos);
+            }
+        }
+    }
+
+    GIVEN("a flush interval of zero") {
+        file_logging_options options;
+        options.flush_interval = chrono::milliseconds(0);
+        file_logging_context context(options);
+
+        WHEN("a trace message is logged") {
+            LOG_TRACE("unbuffered");
+            THEN("it is written immediately") {
+                REQUIRE(context.contents().find("unbuffered") != string::npos);
+            }
+        }
+    }
+
+    GIVEN("a buffer smaller than the messages") {
+        file_logging_options options;
+        options.buffer_size = 16;
+        file_logging_context context(options);
+
+        WHEN("messages are logged") {
+            LOG_DEBUG("first");
+            LOG_DEBUG("second");
+            THEN("they are written as the buffer fills") {
+                auto contents = context.contents();
+                REQUIRE(contents.find("first") != string::npos);
+                REQUIRE(contents.find("second") != string::npos);
+            }
+        }
+    }
+
+    GIVEN("size-based rotation") {
+        file_logging_options options;
+        options.rotate_size = 100;
+        options.rotate_count = 2;
+        auto rotated = make_shared<vector<string>>();
+        auto rotated_mutex = make_shared<mutex>();
+        options.on_rotate = [=](string const& file) {
+            lock_guard<mutex> lock(*rotated_mutex);
+            rotated->push_back(file);
+        };
+        file_logging_context context(options);
+
+        WHEN("more than the rotation size is logged") {
+            for (int i = 0; i < 6; ++i) {
+                LOG_WARNING("message number {1}", i);
+            }
+            clean_file_logging();
+            THEN("the oldest messages are dropped") {
+                REQUIRE_FALSE(fs::exists(context.path + ".3"));
+                REQUIRE(context.contents(context.path + ".2").find("message number 3") != string::npos);
+                REQUIRE(context.contents(context.path + ".1").find("message number 4") != string::npos);
+                REQUIRE(context.contents().find("message number 5") != string::npos);
+            }
+            THEN("the rotation callback is called for each rotated file") {
+                lock_guard<mutex> lock(*rotated_mutex);
+                REQUIRE(rotated->size() == 5u);
+                REQUIRE(rotated->front() == context.path + ".1");
+            }
+        }
+    }
+
+    GIVEN("the log file is moved away") {
+        file_logging_options options;
+        options.reopen_on_sighup = true;
+        file_logging_context context(options);
+        LOG_WARNING("before");
+        fs::rename(context.path, context.path + ".old");
+
+        WHEN("the log is reopened") {
+            reopen_file_logging();
+            LOG_WARNING("after");
+            THEN("new messages are written to a new file") {
+                REQUIRE(context.contents(context.path + ".old").find("before") != string::npos);
+                REQUIRE(context.contents().find("before") == string::npos);
+                REQUIRE(context.contents().find("after") != string::npos);
+            }
+        }
+        WHEN("the process receives SIGHUP") {
+            raise(SIGHUP);
+            LOG_WARNING("after");
+            THEN("new messages are written to a new file") {
+                REQUIRE(context.contents(context.path + ".old").find("after") == string::npos);
+                REQUIRE(context.contents().find("after") != string::npos);
+            }
+        }
+    }
+
+    GIVEN("JSON output") {
+        file_logging_options options;
+        options.json = true;
+        options.json_fields = { { "service", "test" } };
+        file_logging_context context(options);
+
+        WHEN("a warning is logged") {
+            LOG_WARNING("as json");
+            THEN("it is written as a JSON object") {
+                REQUIRE(boost::regex_match(context.contents(), boost::regex(
+                    "\\{\"timestamp\":\"[^\"]+\",\"level\":\"WARN\",\"namespace\":\"" LOG_NAMESPACE "\","
+                    "\"thread\":\\d+,\"message\":\"as json\",\"service\":\"test\"\\}\n")));
+            }
+        }
+    }
+
+    GIVEN("a path that can't be opened") {
+        THEN("setup throws") {
+            REQUIRE_THROWS_AS(setup_file_logging("/nonexistent/directory/test.log"), runtime_error);
+        }
+    }
+}
@@ -0,0 +1,185 @@
+#include <catch.hpp>
+#include <leatherman/logging/logging.hpp>
+#include <boost/filesystem.hpp>
+#include <cstring>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "../logging.hpp"
+
+using namespace std;
+using namespace leatherman::logging;
+namespace fs = boost::filesystem;
+
+namespace leatherman { namespace test {
+
+    /**
+     * Stands in for the syslog daemon by listening on a local datagram socket.
+     */
+    struct syslog_logging_context : logging_context
+    {
+        explicit syslog_logging_context(syslog_options options = syslog_options()) :
+            logging_context(log_level::trace),
+            path((fs::temp_directory_path() / fs::unique_path("lth_syslog_%%%%-%%%%")).string()),
+            fd(socket(AF_UNIX, SOCK_DGRAM, 0))
+        {
+            REQUIRE(fd >= 0);
+            sockaddr_un address;
+            memset(&address, 0, sizeof(address));
+            address.sun_family = AF_UNIX;
+            strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+            REQUIRE(bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0);
+
+            timeval timeout = { 1, 0 };
+            setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+            options.socket_path = path;
+            setup_native_syslog_logging("lth_test", "local0", move(options));
+            set_level(log_level::trace);
+        }
+
+        ~syslog_logging_context()
+        {
+            clean_syslog_logging();
+            disable_syslog();
+            close(fd);
+            fs::remove(path);
+        }
+
+        string receive()
+        {
+            char buffer[4096];
+            auto size = recv(fd, buffer, sizeof(buffer), 0);
+            return size < 0 ? string() : string(buffer, size);
+        }
+
+        string path;
+        int fd;
+    };
+
+}}  // namespace leatherman::test
+
+using namespace leatherman::test;
+
+SCENARIO("logging to syslog with the native client") {
+    auto pid = to_string(getpid());
+
+    GIVEN("the default options") {
+        syslog_logging_context context;
+
+        WHEN("an info message is logged") {
+            LOG_INFO("testing {1} {2} {3}", 1, "2", 3.0);
+            THEN("it is queued until flushed") {
+                REQUIRE(get_syslog_stats().sent == 0u);
+                flush_syslog_logging();
+                REQUIRE(get_syslog_stats().sent == 1u);
+                auto message = context.receive();
+                REQUIRE(boost::regex_match(message, boost::regex(
+                    "<134>[A-Z][a-z]{2} [ 1-3]\\d [0-2]\\d:[0-5]\\d:\\d{2} lth_test\\[" + pid + "\\]: testing 1 2 3")));
+            }
+            THEN("it is sent by the background thread") {
+                REQUIRE(context.receive().find("testing 1 2 3") != string::npos);
+            }
+        }
+        WHEN("an error is logged") {
+            LOG_ERROR("error message");
+            THEN("it is sent immediately") {
+                REQUIRE(get_syslog_stats().sent == 1u);
+                auto message = context.receive();
+                REQUIRE(message.substr(0, 5) == "<131>");
+                REQUIRE(message.find("error message") != string::npos);
+            }
+        }
+        WHEN("a message is logged in a logging context") {
+            scoped_log_context request("request_id", "abc");
+            LOG_ERROR("in context");
+            THEN("the context precedes the message") {
+                REQUIRE(context.receive().find("]: [request_id=abc] in context") != string::npos);
+            }
+        }
+        WHEN("several messages are logged") {
+            for (int i = 0; i < 10; ++i) {
+                LOG_DEBUG("message {1}", i);
+            }
+            flush_syslog_logging();
+            THEN("they are all sent in order") {
+                REQUIRE(get_syslog_stats().sent == 10u);
+                for (int i = 0; i < 10; ++i) {
+                    auto message = context.receive();
+                    REQUIRE(message.substr(0, 5) == "<135>");
+                    REQUIRE(message.find("message " + to_string(i)) != string::npos);
+                }
+            }
+        }
+    }
+
+    GIVEN("RFC 5424 formatting") {
+        syslog_options options;
+        options.rfc5424 = true;
+        syslog_logging_context context(options);
+
+        WHEN("a warning is logged") {
+            LOG_WARNING("warning message");
+            flush_syslog_logging();
+            THEN("it has a version and an ISO 8601 timestamp") {
+                auto message = context.receive();
+                REQUIRE(boost::regex_match(message, boost::regex(
+                    "<132>1 \\d{4}-\\d{2}-\\d{2}T\\d{2}:\\d{2}:\\d{2}\\.\\d{6}Z \\S+ lth_test " + pid + " - - warning message")));
+            }
+        }
+        WHEN("a warning is logged in a logging context") {
+            scoped_log_context request("request_id", "a]b");
+            scoped_log_context probe("bad name", "disk");
+            LOG_WARNING("warning message");
+            flush_syslog_logging();
+            THEN("the context is rendered as structured data") {
+                auto message = context.receive();
+                REQUIRE(message.find(" - [context@32473 request_id=\"a\\]b\" bad_name=\"disk\"] warning message") != string::npos);
+            }
+        }
+    }
+
+    GIVEN("a small queue") {
+        syslog_options options;
+        options.queue_size = 2;
+        options.flush_interval = chrono::milliseconds(60000);
+        syslog_logging_context context(options);
+
+        WHEN("more messages are logged than fit") {
+            LOG_INFO("one");
+            LOG_INFO("two");
+            LOG_INFO("three");
+            THEN("the extra message is dropped") {
+                REQUIRE(get_syslog_stats().dropped == 1u);
+                flush_syslog_logging();
+                REQUIRE(get_syslog_stats().sent == 2u);
+            }
+        }
+    }
+
+    GIVEN("no listening syslog daemon") {
+        syslog_options options;
+        options.socket_path = "/nonexistent/syslog";
+        setup_native_syslog_logging("lth_test", "user", options);
+        set_level(log_level::trace);
+
+        WHEN("a message is logged") {
+            LOG_ERROR("lost message");
+            THEN("it is counted as dropped") {
+                REQUIRE(get_syslog_stats().sent == 0u);
+                REQUIRE(get_syslog_stats().dropped == 1u);
+            }
+        }
+
+        clean_syslog_logging();
+        disable_syslog();
+        set_level(log_level::none);
+        clear_error_logged_flag();
+    }
+
+    GIVEN("an invalid facility") {
+        THEN("setup throws") {
+            REQUIRE_THROWS_AS(setup_native_syslog_logging("lth_test", "bogus"), runtime_error);
+        }
+    }
+}